@@ -0,0 +1,159 @@
+#pragma once
+
+// LAN fan-out datagram and leader election. Free of AsyncUDP and FreeRTOS so the
+// native tests (test/test_fanout) can drive them with synthetic packets and times.
+
+#include <stdint.h>
+#include <string.h>
+
+#define FANOUT_VERSION 2
+#define FANOUT_FLAG_NO_PRICE 0x01    // Leader is up but has no price yet; ageMs is its time as leader
+
+// Fan-out datagram, little-endian and packed. Receivers drop anything with another
+// magic, version or length, so the format can change by bumping FANOUT_VERSION.
+struct __attribute__((packed)) FanoutPacket {
+    char magic[4];        // "BTCF"
+    uint8_t version;      // FANOUT_VERSION
+    uint8_t flags;        // FANOUT_FLAG_*
+    uint32_t leaderId;    // Sender's ID; the lowest ID wins a leadership conflict
+    uint32_t sequence;    // Per-leader counter, for loss accounting
+    uint32_t ageMs;       // Age of the price at the leader
+    double price;
+    float change1h;
+    float change1d;
+    float change24h;
+};
+
+enum FanoutRole {
+    FANOUT_OFF,       // Fan-out disabled - fetch independently
+    FANOUT_LEADER,    // Fetching and broadcasting
+    FANOUT_FOLLOWER   // Rendering the leader's broadcasts, fetch tasks idle
+};
+
+// Fill a datagram. A leader without a price still sends one, flagged, so followers
+// know it is alive; ageMs is then how long it has led without getting a price.
+inline void encodeFanoutPacket(FanoutPacket& packet, uint32_t leaderId, uint32_t sequence, uint32_t ageMs,
+                               double price, float change1h, float change1d, float change24h) {
+    memcpy(packet.magic, "BTCF", 4);
+    packet.version = FANOUT_VERSION;
+    packet.flags = price > 0 ? 0 : FANOUT_FLAG_NO_PRICE;
+    packet.leaderId = leaderId;
+    packet.sequence = sequence;
+    packet.ageMs = ageMs;
+    packet.price = price > 0 ? price : 0;
+    packet.change1h = change1h;
+    packet.change1d = change1d;
+    packet.change24h = change24h;
+}
+
+// Copy a received datagram into packet if it is one of ours, in this version
+inline bool decodeFanoutPacket(const uint8_t* data, size_t length, FanoutPacket& packet) {
+    if (length != sizeof(packet)) {
+        return false;
+    }
+    memcpy(&packet, data, sizeof(packet));
+    return memcmp(packet.magic, "BTCF", 4) == 0 && packet.version == FANOUT_VERSION;
+}
+
+// What a received datagram means for this device
+enum FanoutAction {
+    FANOUT_IGNORE,        // Our own loopback, a leader we outrank, or a stale rival
+    FANOUT_FOLLOW,        // From the current leader
+    FANOUT_NEW_LEADER     // Now following a different leader
+};
+
+// Election state. A follower takes over when the leader has been silent for
+// leaderTimeout, or has only advertised a price older than staleAfter for another
+// staleAfter - a leader whose fetches all fail keeps heartbeating, so silence alone
+// wouldn't replace it. Both waits are staggered by ID so followers of a lost leader
+// don't all promote at once.
+struct FanoutElection {
+    volatile FanoutRole role;
+    uint32_t selfId;
+    volatile uint32_t leaderId;
+    uint32_t lastSequence;
+    uint32_t missed;                        // Datagrams lost from the current leader
+    unsigned long lastLeaderPacket;         // Last packet from the current leader
+    unsigned long lastFreshPacket;          // ... with a fresh price, or since following it
+    unsigned long leaderSince;              // When this device took the role
+    unsigned long leaderTimeout;
+    unsigned long staleAfter;
+    
+    FanoutElection(bool enabled)
+        : role(enabled ? FANOUT_FOLLOWER : FANOUT_OFF),  // Listen first at boot
+          selfId(0), leaderId(0), lastSequence(0), missed(0), lastLeaderPacket(0), lastFreshPacket(0),
+          leaderSince(0), leaderTimeout(0), staleAfter(0) {}
+    
+    void begin(uint32_t id, unsigned long timeout, unsigned long staleAge) {
+        selfId = id;
+        leaderTimeout = timeout;
+        staleAfter = staleAge;
+    }
+    
+    // Joined the group: listen for a full timeout before taking over
+    void listening(unsigned long now) {
+        lastLeaderPacket = now;
+        lastFreshPacket = now;
+    }
+    
+    bool stale(uint32_t ageMs) const {
+        return ageMs > staleAfter;
+    }
+    
+    // ageMs to advertise as leader: the price's age, or how long it has led without one
+    uint32_t advertisedAge(bool havePrice, unsigned long priceAge, unsigned long now) const {
+        return havePrice ? priceAge : now - leaderSince;
+    }
+    
+    // Account for a decoded packet; ownAge is what this device advertises if it leads.
+    // Values are worth applying from FANOUT_FOLLOW/FANOUT_NEW_LEADER packets without
+    // FANOUT_FLAG_NO_PRICE.
+    FanoutAction onPacket(const FanoutPacket& packet, uint32_t ownAge, unsigned long now) {
+        if (role == FANOUT_OFF || packet.leaderId == selfId) {
+            return FANOUT_IGNORE;  // Our own multicast looped back
+        }
+        bool theirsStale = stale(packet.ageMs);
+        
+        // Two leaders (simultaneous boot or takeover): a fresh price beats a stale one,
+        // otherwise the lower ID keeps the role. A new leader counts as fresh for
+        // staleAfter, so it gets a chance to fetch before the stale one outranks it.
+        if (role == FANOUT_LEADER) {
+            bool oursStale = stale(ownAge) && now - leaderSince > staleAfter;
+            if (oursStale == theirsStale ? packet.leaderId > selfId : theirsStale) {
+                return FANOUT_IGNORE;
+            }
+            role = FANOUT_FOLLOWER;
+            leaderId = 0;  // Follow the winner even if its price is stale too
+        }
+        
+        FanoutAction action = FANOUT_FOLLOW;
+        if (packet.leaderId != leaderId) {
+            if (theirsStale && leaderId != 0) {
+                return FANOUT_IGNORE;  // A stale rival doesn't pull followers off the current leader
+            }
+            leaderId = packet.leaderId;
+            lastFreshPacket = now;
+            action = FANOUT_NEW_LEADER;
+        } else if (packet.sequence > lastSequence + 1) {
+            missed += packet.sequence - lastSequence - 1;
+        }
+        lastSequence = packet.sequence;
+        lastLeaderPacket = now;
+        if (!theirsStale) {
+            lastFreshPacket = now;
+        }
+        return action;
+    }
+    
+    bool shouldTakeOver(unsigned long now) const {
+        unsigned long stagger = selfId % 1000;
+        return role == FANOUT_FOLLOWER &&
+               (now - lastLeaderPacket > leaderTimeout + stagger || now - lastFreshPacket > staleAfter + stagger);
+    }
+    
+    void takeOver(unsigned long now) {
+        role = FANOUT_LEADER;
+        leaderId = selfId;
+        leaderSince = now;
+    }
+};
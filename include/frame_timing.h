@@ -0,0 +1,105 @@
+#pragma once
+
+// Time-driven scrolling and frame pacing. Free of Arduino/FreeRTOS calls so the
+// native test env can drive them with a fake clock (test/test_scroll).
+// MATRIX_WIDTH comes from the build flags, as for the firmware.
+
+#include <math.h>
+#include <stdint.h>
+
+#ifndef IDLE_FRAME_MS
+#define IDLE_FRAME_MS 100      // Longest render sleep when nothing is animating
+#endif
+
+// Scroll state structure for independent scrolling text management.
+// Position is driven by elapsed time at a fixed velocity, so stalls in loop()
+// (web requests, mutex waits, show()) don't slow the visible scroll.
+struct ScrollState {
+    float position;             // Sub-pixel x position of the text's left edge
+    float velocity;             // Pixels per second (scrolling left)
+    unsigned long lastUpdate;   // millis() of the last advance()
+    bool started;               // False until the first advance() after a reset
+    
+    ScrollState(int16_t startOffset = MATRIX_WIDTH, unsigned long msPerPixel = 100)
+        : position(startOffset), velocity(1000.0f / msPerPixel), lastUpdate(0), started(false) {}
+    
+    // Move left by however much time has passed since the previous call
+    void advance(unsigned long now) {
+        if (started) {
+            position -= (now - lastUpdate) * velocity / 1000.0f;
+        }
+        lastUpdate = now;
+        started = true;
+    }
+    
+    int16_t offset() const {
+        return (int16_t)floorf(position);
+    }
+    
+    // Fractional part of the position (0.0 - 1.0), used for sub-pixel blending
+    float fraction() const {
+        return position - floorf(position);
+    }
+    
+    // Restart from resetOffset once textWidth pixels have scrolled off the left edge.
+    // Any overshoot is carried over so the average speed stays exact.
+    void wrap(int16_t resetOffset, int16_t textWidth) {
+        if (position < -textWidth) {
+            position += resetOffset + textWidth;
+            if (position < -textWidth) {
+                position = resetOffset;  // Stalled for more than a full cycle
+            }
+        }
+    }
+    
+    void reset(int16_t resetOffset = MATRIX_WIDTH) {
+        position = resetOffset;
+        started = false;
+    }
+};
+
+// Holds loop() to a fixed frame rate, resyncing instead of bursting after a stall.
+// The wait is a notification wait, so a fetch task publishing a new price wakes the
+// renderer immediately instead of at the next frame boundary.
+//
+// Clock supplies the time base and the wait:
+//   static unsigned long micros();
+//   static bool waitForNotify(unsigned long ms);  // true if woken by a notification
+template <typename Clock>
+struct FramePacer {
+    unsigned long frameMicros;
+    unsigned long nextFrame;
+    unsigned long missedFrames;  // Frames that overran their deadline
+    bool updateSignalled;        // Woken early by a price update notification
+    
+    FramePacer(unsigned int fps) : frameMicros(1000000UL / fps), nextFrame(0), missedFrames(0), updateSignalled(false) {}
+    
+    void wait(bool animating = true) {
+        if (!animating) {
+            // Nothing moving on screen - sleep until new data or the idle timeout
+            if (Clock::waitForNotify(IDLE_FRAME_MS)) {
+                updateSignalled = true;
+            }
+            nextFrame = Clock::micros() + frameMicros;
+            return;
+        }
+        
+        unsigned long now = Clock::micros();
+        long remaining = (long)(nextFrame - now);
+        if (remaining > 0) {
+            if (remaining >= 1000 && Clock::waitForNotify(remaining / 1000)) {
+                updateSignalled = true;  // Render the new data now, keep the frame schedule
+                return;
+            }
+            while ((long)(nextFrame - Clock::micros()) > 0) {
+                // Spin out the sub-millisecond remainder
+            }
+            nextFrame += frameMicros;
+        } else {
+            if (nextFrame != 0) {
+                missedFrames++;
+            }
+            nextFrame = now + frameMicros;  // Fell behind - don't try to catch up
+        }
+    }
+};
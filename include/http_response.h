@@ -0,0 +1,186 @@
+#pragma once
+
+// HTTP/1.1 response reader for the fetch paths: status line, the headers the fetchers
+// act on, then a Content-Length or chunked body into a caller-owned buffer - nothing
+// is allocated. Shared by the firmware's httpGet and the native tests (test/test_alloc).
+//
+// Transport is anything with:
+//   int read();                              // next byte, -1 if none has arrived yet
+//   int read(uint8_t* buffer, size_t len);   // bytes read, <= 0 if none
+//   bool connected();
+//   unsigned long now();                     // millis()
+//   void idle();                             // wait a tick for more data
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define HTTP_LINE_BYTES 160  // Longer response header lines are truncated
+
+struct HttpResponse {
+    int status;            // -1 for a malformed, truncated or oversized response
+    size_t bodyLen;
+    unsigned long maxAge;  // Cache-Control max-age (ms), 0 if absent
+    bool keepAlive;        // False if the server closes the connection or the response failed
+};
+
+// Read one CRLF-terminated line (without the CRLF). Overlong lines are truncated.
+template <typename Transport>
+bool readHttpLine(Transport& transport, char* line, size_t lineLen, unsigned long deadline) {
+    size_t len = 0;
+    while ((long)(transport.now() - deadline) < 0) {
+        int c = transport.read();
+        if (c < 0) {
+            if (!transport.connected()) {
+                return false;
+            }
+            transport.idle();
+            continue;
+        }
+        if (c == '\n') {
+            if (len > 0 && line[len - 1] == '\r') {
+                len--;
+            }
+            line[len] = '\0';
+            return true;
+        }
+        if (len < lineLen - 1) {
+            line[len++] = (char)c;
+        }
+    }
+    return false;
+}
+
+// Read exactly len bytes
+template <typename Transport>
+bool readHttpBytes(Transport& transport, char* buffer, size_t len, unsigned long deadline) {
+    size_t received = 0;
+    while (received < len) {
+        if ((long)(transport.now() - deadline) >= 0) {
+            return false;
+        }
+        int count = transport.read((uint8_t*)buffer + received, len - received);
+        if (count > 0) {
+            received += count;
+        } else if (!transport.connected()) {
+            return false;
+        } else {
+            transport.idle();
+        }
+    }
+    return true;
+}
+
+// Value of a "Name: value" header line if it is the named header, else NULL
+inline const char* httpHeaderValue(const char* line, const char* name) {
+    size_t nameLen = strlen(name);
+    if (strncasecmp(line, name, nameLen) != 0 || line[nameLen] != ':') {
+        return NULL;
+    }
+    const char* value = line + nameLen + 1;
+    while (*value == ' ') {
+        value++;
+    }
+    return value;
+}
+
+// Extract max-age (in ms) from a Cache-Control header, 0 if absent
+inline unsigned long parseMaxAge(const char* cacheControl) {
+    const char* pos = strstr(cacheControl, "max-age=");
+    if (pos == NULL) {
+        return 0;
+    }
+    return strtoul(pos + 8, NULL, 10) * 1000UL;
+}
+
+// Parse a "bytes <first>-<last>/<total>" Content-Range value; total is -1 for "/*".
+// False if it isn't a byte range.
+inline bool parseContentRange(const char* value, size_t& first, long& total) {
+    if (strncmp(value, "bytes ", 6) != 0) {
+        return false;
+    }
+    char* end;
+    first = strtoul(value + 6, &end, 10);
+    const char* slash = strchr(end, '/');
+    if (end == value + 6 || *end != '-' || slash == NULL) {
+        return false;
+    }
+    total = slash[1] == '*' ? -1 : strtol(slash + 1, NULL, 10);
+    return true;
+}
+
+// Read a response to a request already sent. The body lands NUL-terminated in body
+// (so it must fit in capacity - 1 bytes); an ETag that fits is copied to etag, which
+// is left empty otherwise. Bodies running to connection close aren't supported.
+template <typename Transport>
+HttpResponse readHttpResponse(Transport& transport, char* body, size_t capacity, char* etag, size_t etagLen,
+                              unsigned long deadline) {
+    HttpResponse response = {-1, 0, 0, false};
+    etag[0] = '\0';
+    char line[HTTP_LINE_BYTES];
+    if (!readHttpLine(transport, line, sizeof(line), deadline) || strncmp(line, "HTTP/1.", 7) != 0) {
+        return response;
+    }
+    int status = atoi(line + 9);
+    
+    long contentLength = -1;
+    bool chunked = false, keepAlive = true;
+    while (true) {
+        if (!readHttpLine(transport, line, sizeof(line), deadline)) {
+            return response;
+        }
+        if (line[0] == '\0') {
+            break;  // End of headers
+        }
+        const char* value;
+        if ((value = httpHeaderValue(line, "ETag")) != NULL) {
+            if (strlen(value) < etagLen) {
+                strcpy(etag, value);
+            }
+        } else if ((value = httpHeaderValue(line, "Cache-Control")) != NULL) {
+            response.maxAge = parseMaxAge(value);
+        } else if ((value = httpHeaderValue(line, "Content-Length")) != NULL) {
+            contentLength = atol(value);
+        } else if ((value = httpHeaderValue(line, "Transfer-Encoding")) != NULL) {
+            chunked = strstr(value, "chunked") != NULL;
+        } else if ((value = httpHeaderValue(line, "Connection")) != NULL) {
+            keepAlive = strcasecmp(value, "close") != 0;
+        }
+    }
+    
+    size_t bodyLen = 0;
+    bool complete = true;
+    if (status == 304 || status == 204) {
+        // No body
+    } else if (chunked) {
+        while (complete) {
+            complete = readHttpLine(transport, line, sizeof(line), deadline);
+            size_t chunk = strtoul(line, NULL, 16);
+            if (!complete || chunk == 0) {
+                break;
+            }
+            complete = bodyLen + chunk < capacity && readHttpBytes(transport, body + bodyLen, chunk, deadline) &&
+                       readHttpLine(transport, line, sizeof(line), deadline);
+            bodyLen += chunk;
+        }
+        // Trailers end with an empty line
+        while (complete && (complete = readHttpLine(transport, line, sizeof(line), deadline)) && line[0] != '\0') {
+        }
+    } else if (contentLength >= 0) {
+        complete = (size_t)contentLength < capacity && readHttpBytes(transport, body, contentLength, deadline);
+        bodyLen = contentLength;
+    } else {
+        complete = false;  // Body runs to connection close - not worth supporting
+    }
+    
+    if (!complete) {
+        return response;
+    }
+    body[bodyLen] = '\0';
+    response.status = status;
+    response.bodyLen = bodyLen;
+    response.keepAlive = keepAlive;
+    return response;
+}
@@ -0,0 +1,223 @@
+#pragma once
+
+// Deferred log records: the argument packing done at LOG_* call sites, the lock-free
+// ring LogTask drains, and the formatting it does afterwards. Free of FreeRTOS and
+// Serial so the native tests (test/test_log) can check and time them on the host.
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <type_traits>
+
+#ifndef LOG_QUEUE_SIZE
+#define LOG_QUEUE_SIZE 32      // Records; must be a power of two
+#endif
+#define LOG_MAX_ARGS 6
+#define LOG_TEXT_BYTES 64      // Per-record space for copies of string arguments
+
+// One raw log argument, formatted later by LogTask
+struct LogArg {
+    enum : uint8_t { INTEGER, REAL, TEXT } type;
+    union {
+        int64_t integer;
+        double real;
+        uint8_t textOffset;  // Into LogRecord::text
+    };
+};
+
+struct LogRecord {
+    const char* format;        // String literal - its address doubles as the message ID
+    unsigned long timestamp;   // millis() at the call site
+    uint8_t level;
+    uint8_t argCount;
+    uint8_t textUsed;
+    LogArg args[LOG_MAX_ARGS];
+    char text[LOG_TEXT_BYTES];
+};
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+logPackArg(LogRecord& record, T value) {
+    LogArg& arg = record.args[record.argCount++];
+    arg.type = LogArg::INTEGER;
+    arg.integer = (int64_t)value;
+}
+
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value>::type
+logPackArg(LogRecord& record, T value) {
+    LogArg& arg = record.args[record.argCount++];
+    arg.type = LogArg::REAL;
+    arg.real = value;
+}
+
+// Strings are copied (truncated to the space left) so callers may pass stack buffers
+inline void logPackArg(LogRecord& record, const char* value) {
+    LogArg& arg = record.args[record.argCount++];
+    arg.type = LogArg::TEXT;
+    arg.textOffset = record.textUsed;
+    size_t room = LOG_TEXT_BYTES - record.textUsed;
+    if (room == 0) {
+        arg.textOffset = LOG_TEXT_BYTES - 1;  // Points at the final NUL
+        return;
+    }
+    const char* source = value != NULL ? value : "";
+    size_t len = 0;
+    while (len < room - 1 && source[len] != '\0') {  // strnlen, without GCC's overread warning on literals
+        len++;
+    }
+    memcpy(record.text + record.textUsed, source, len);
+    record.text[record.textUsed + len] = '\0';
+    record.textUsed += len + 1;
+}
+
+inline void logPackArg(LogRecord& record, char* value) {
+    logPackArg(record, (const char*)value);
+}
+
+inline void logPackArgs(LogRecord&) {
+}
+
+template <typename T, typename... Rest>
+void logPackArgs(LogRecord& record, T value, Rest... rest) {
+    logPackArg(record, value);
+    logPackArgs(record, rest...);
+}
+
+// Bounded lock-free MPSC ring (per-slot sequence numbers): any task may log, only
+// LogTask consumes. A full ring drops the record rather than blocking the caller.
+struct LogSlot {
+    std::atomic<uint32_t> sequence;
+    LogRecord record;
+};
+
+static_assert((LOG_QUEUE_SIZE & (LOG_QUEUE_SIZE - 1)) == 0, "LOG_QUEUE_SIZE must be a power of two");
+
+struct LogRing {
+    LogSlot slots[LOG_QUEUE_SIZE];
+    std::atomic<uint32_t> enqueuePos;
+    uint32_t dequeuePos;
+    std::atomic<uint32_t> dropped;   // Records refused while full, since LogTask last reported
+    
+    LogRing() : enqueuePos(0), dequeuePos(0), dropped(0) {
+        for (uint32_t i = 0; i < LOG_QUEUE_SIZE; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    
+    // Claim a slot and copy the arguments into it; false (and counted) if full
+    template <typename... Args>
+    bool push(uint8_t level, unsigned long timestamp, const char* format, Args... args) {
+        static_assert(sizeof...(Args) <= LOG_MAX_ARGS, "Too many log arguments");
+        
+        uint32_t pos = enqueuePos.load(std::memory_order_relaxed);
+        LogSlot* slot;
+        while (true) {
+            slot = &slots[pos & (LOG_QUEUE_SIZE - 1)];
+            int32_t diff = (int32_t)(slot->sequence.load(std::memory_order_acquire) - pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                dropped.fetch_add(1, std::memory_order_relaxed);  // Full
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+        
+        LogRecord& record = slot->record;
+        record.format = format;
+        record.timestamp = timestamp;
+        record.level = level;
+        record.argCount = 0;
+        record.textUsed = 0;
+        logPackArgs(record, args...);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+    
+    // Pop the oldest completed record, if any. Only the consumer calls this.
+    bool pop(LogRecord& record) {
+        LogSlot& slot = slots[dequeuePos & (LOG_QUEUE_SIZE - 1)];
+        if ((int32_t)(slot.sequence.load(std::memory_order_acquire) - (dequeuePos + 1)) < 0) {
+            return false;
+        }
+        record = slot.record;
+        slot.sequence.store(dequeuePos + LOG_QUEUE_SIZE, std::memory_order_release);
+        dequeuePos++;
+        return true;
+    }
+};
+
+// Expand a record's format with its saved arguments. Each conversion is handed to
+// snprintf on its own, cast to the type its length modifier asks for.
+inline void formatLogRecord(const LogRecord& record, char* out, size_t outLen) {
+    size_t used = 0;
+    int argIndex = 0;
+    
+    for (const char* p = record.format; *p != '\0' && used < outLen - 1; ) {
+        if (*p != '%') {
+            out[used++] = *p++;
+            continue;
+        }
+        if (p[1] == '%') {
+            out[used++] = '%';
+            p += 2;
+            continue;
+        }
+        
+        // Isolate one conversion spec: %[flags][width][.precision][length]conversion
+        char spec[16];
+        size_t specLen = strspn(p + 1, "-+ #0123456789.hlzjt") + 2;
+        if (specLen >= sizeof(spec) || p[specLen - 1] == '\0') {
+            break;
+        }
+        memcpy(spec, p, specLen);
+        spec[specLen] = '\0';
+        p += specLen;
+        
+        char conversion = spec[specLen - 1];
+        int longs = (strchr(spec, 'l') != NULL) + (strstr(spec, "ll") != NULL);
+        const LogArg* arg = argIndex < record.argCount ? &record.args[argIndex++] : NULL;
+        int written = 0;
+        size_t room = outLen - used;
+        
+        if (arg == NULL) {
+            written = snprintf(out + used, room, "?");
+        } else if (conversion == 's') {
+            written = snprintf(out + used, room, spec, arg->type == LogArg::TEXT ? record.text + arg->textOffset : "?");
+        } else if (strchr("feEgGaA", conversion) != NULL) {
+            written = snprintf(out + used, room, spec, arg->type == LogArg::REAL ? arg->real : (double)arg->integer);
+        } else {
+            int64_t value = arg->type == LogArg::REAL ? (int64_t)arg->real : arg->integer;
+            if (longs == 2) {
+                written = snprintf(out + used, room, spec, (long long)value);
+            } else if (longs == 1) {
+                written = snprintf(out + used, room, spec, (long)value);
+            } else {
+                written = snprintf(out + used, room, spec, (int)value);
+            }
+        }
+        used += written > 0 ? std::min((size_t)written, room - 1) : 0;
+    }
+    out[used] = '\0';
+}
+
+#define LOG_TAG_BYTES 4        // "[I] " ahead of the message in a formatted line
+
+// Format "[I] message" into out, NUL-terminated with a byte to spare so the caller can
+// append '\n' and write the line in one go. Returns its length; the bare message
+// (for the web console) starts at out + LOG_TAG_BYTES.
+inline size_t formatLogLine(const LogRecord& record, char* out, size_t outLen) {
+    static const char levelTags[] = {'?', 'E', 'W', 'I', 'D'};
+    out[0] = '[';
+    out[1] = record.level < sizeof(levelTags) ? levelTags[record.level] : '?';
+    out[2] = ']';
+    out[3] = ' ';
+    formatLogRecord(record, out + LOG_TAG_BYTES, outLen - LOG_TAG_BYTES - 1);
+    return LOG_TAG_BYTES + strlen(out + LOG_TAG_BYTES);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+// Price source adapters: USD price and 24h change (%) from each API's response, plus
+// the 1h change where the API has one (change1h is left alone otherwise). Each parses
+// with a filter into a small fixed document on the lane's stack. Filters are sized
+// with JSON_*_SIZE so they fit 64-bit hosts too, where the tests (test/test_parsers)
+// run them against recorded response bodies.
+
+#include <stdlib.h>
+#include <ArduinoJson.h>
+
+// CoinGecko simple/price: {"bitcoin":{"usd":..,"usd_24h_change":..}}
+inline bool parseCoinGeckoPrice(const char* body, size_t len, double& price, double& change24h, double& change1h) {
+    StaticJsonDocument<JSON_OBJECT_SIZE(1) + JSON_OBJECT_SIZE(2)> filter;
+    filter["bitcoin"]["usd"] = true;
+    filter["bitcoin"]["usd_24h_change"] = true;
+    
+    StaticJsonDocument<128> doc;
+    // isNull, not !: a flat market reports a 24h change of exactly 0
+    if (deserializeJson(doc, body, len, DeserializationOption::Filter(filter)) != DeserializationError::Ok ||
+        doc["bitcoin"]["usd"].isNull() || doc["bitcoin"]["usd_24h_change"].isNull()) {
+        return false;
+    }
+    price = doc["bitcoin"]["usd"];
+    change24h = doc["bitcoin"]["usd_24h_change"];
+    return price > 0;
+}
+
+// CoinGecko coins/markets: [{"id":"bitcoin","current_price":..,"price_change_percentage_24h":..,
+// "price_change_percentage_1h_in_currency":..,...}]. The ~1 KB object (image URL, supply,
+// ATH, ROI...) is filtered down to three fields while parsing, so a small fixed document does.
+inline bool parseCoinGeckoMarkets(const char* body, size_t len, double& price, double& change24h, double& change1h) {
+    StaticJsonDocument<JSON_ARRAY_SIZE(1) + JSON_OBJECT_SIZE(3)> filter;
+    filter[0]["current_price"] = true;
+    filter[0]["price_change_percentage_24h"] = true;
+    filter[0]["price_change_percentage_1h_in_currency"] = true;
+    
+    StaticJsonDocument<256> doc;
+    if (deserializeJson(doc, body, len, DeserializationOption::Filter(filter)) != DeserializationError::Ok) {
+        return false;
+    }
+    JsonObject coin = doc[0];
+    if (coin["current_price"].isNull() || coin["price_change_percentage_24h"].isNull()) {
+        return false;
+    }
+    price = coin["current_price"];
+    change24h = coin["price_change_percentage_24h"];
+    if (!coin["price_change_percentage_1h_in_currency"].isNull()) {
+        change1h = coin["price_change_percentage_1h_in_currency"];
+    }
+    return price > 0;
+}
+
+// Coinbase Exchange stats: {"open":"..","last":"..",...} as strings, open is 24h ago
+inline bool parseCoinbasePrice(const char* body, size_t len, double& price, double& change24h, double& change1h) {
+    StaticJsonDocument<JSON_OBJECT_SIZE(2)> filter;
+    filter["open"] = true;
+    filter["last"] = true;
+    
+    StaticJsonDocument<192> doc;
+    if (deserializeJson(doc, body, len, DeserializationOption::Filter(filter)) != DeserializationError::Ok) {
+        return false;
+    }
+    double open = atof(doc["open"] | "0");
+    price = atof(doc["last"] | "0");
+    if (open <= 0 || price <= 0) {
+        return false;
+    }
+    change24h = (price - open) / open * 100.0;
+    return true;
+}
+
+// Binance 24h ticker: {"lastPrice":"..","priceChangePercent":"..",...} as strings (USDT pair)
+inline bool parseBinancePrice(const char* body, size_t len, double& price, double& change24h, double& change1h) {
+    StaticJsonDocument<JSON_OBJECT_SIZE(2)> filter;
+    filter["lastPrice"] = true;
+    filter["priceChangePercent"] = true;
+    
+    StaticJsonDocument<192> doc;
+    if (deserializeJson(doc, body, len, DeserializationOption::Filter(filter)) != DeserializationError::Ok ||
+        doc["priceChangePercent"].isNull()) {
+        return false;
+    }
+    price = atof(doc["lastPrice"] | "0");
+    change24h = atof(doc["priceChangePercent"] | "0");
+    return price > 0;
+}
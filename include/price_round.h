@@ -0,0 +1,69 @@
+#pragma once
+
+// The hedged price round's dispatch loop, kept free of FreeRTOS so the native tests
+// (test/test_round) can drive it with fake lanes and a fake clock.
+//
+// Lanes is anything with:
+//   unsigned long now();                                  // millis()
+//   bool dispatch(int source);                            // false if every lane is busy
+//   bool await(unsigned long waitMs, int& source, bool& good);  // false on timeout or
+//                                                         // an answer from an older round
+//   void hedged(int primary, int hedge, unsigned long elapsed);
+
+struct RoundOutcome {
+    int winner;       // Source whose answer was used, -1 if none was good
+    int dispatched;   // How many of ranked[] were sent out
+    bool hedged;      // A hedge was fired while the primary was overdue
+};
+
+// Send ranked[0] first. While it is the only request out and hedgeDelay has passed,
+// fire ranked[1] alongside it - at most one hedge per round. A failed answer fails
+// over to the next source. If every lane is still busy with an earlier round, the
+// round waits for one to free up rather than giving up. The first good answer wins.
+template <typename Lanes>
+RoundOutcome runHedgedRound(Lanes& lanes, const int* ranked, int candidates, unsigned long hedgeDelay,
+                            unsigned long timeout, bool hedging) {
+    RoundOutcome outcome = {-1, 0, false};
+    unsigned long start = lanes.now();
+    unsigned long deadline = start + timeout;
+    unsigned long hedgeAt = start + hedgeDelay;
+    int outstanding = 0;
+    
+    while (outcome.winner < 0 && (long)(lanes.now() - deadline) < 0) {
+        unsigned long now = lanes.now();
+        bool primaryAlone = outcome.dispatched == 1 && outstanding == 1;
+        bool overdue = hedging && primaryAlone && (long)(now - hedgeAt) >= 0;
+        if (outcome.dispatched < candidates && (outstanding == 0 || overdue) &&
+            lanes.dispatch(ranked[outcome.dispatched])) {
+            if (overdue) {
+                outcome.hedged = true;
+                lanes.hedged(ranked[0], ranked[1], now - start);
+            }
+            outcome.dispatched++;
+            outstanding++;
+        }
+        if (outstanding == 0 && outcome.dispatched >= candidates) {
+            break;  // Nothing in flight and nothing left to try
+        }
+        
+        // Wake at the hedge point if one is still to come; otherwise an answer (which
+        // also frees a lane for a pending dispatch) or the deadline
+        unsigned long wakeAt = deadline;
+        bool hedgePending = hedging && outcome.dispatched == 1 && outstanding == 1 && candidates > 1;
+        if (hedgePending && (long)(hedgeAt - now) > 0 &&
+            (long)(hedgeAt - deadline) < 0) {
+            wakeAt = hedgeAt;
+        }
+        long wait = (long)(wakeAt - lanes.now());
+        int source;
+        bool good;
+        if (!lanes.await(wait > 0 ? (unsigned long)wait : 0, source, good)) {
+            continue;
+        }
+        outstanding--;
+        if (good) {
+            outcome.winner = source;
+        }
+    }
+    return outcome;
+}
@@ -0,0 +1,252 @@
+#pragma once
+
+// Binary tick/frame recording format and record ring, shared by the firmware's
+// recorder and replay, the native tests (test/test_recording) and
+// scripts/replay_recording.py.
+//
+// Recording layout (little-endian), as downloaded from /recording:
+//   file header:   "BTCR" u8 version, u16 LED count, u8 width, u8 height
+//   records:       the tick ring's records, then the frame ring's, each oldest first
+//   each record:   u8 type, u16 payload length, u32 millis(), payload
+//   REC_TICK:      f64 price, f32 1h change, f32 1d change, f32 24h change
+//   REC_KEYFRAME:  render inputs, then LED count x RGB (leds[] order)
+//   REC_DELTA:     render inputs, then runs of u16 first LED, u8 count, count x RGB
+//                  (changes since the previous frame record)
+//   render inputs: f32 scroll position, f64 price, f64 1h/1d/24h change - everything
+//                  the ticker was drawn from, so replay can re-render the frame exactly
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#define REC_VERSION 2
+#define REC_FILE_HEADER_BYTES 9  // "BTCR", version, LED count, width, height
+#define REC_HEADER_BYTES 7       // type, payload length, timestamp
+#define REC_TICK_BYTES 20        // f64 price + 3 x f32 changes
+#define REC_INPUT_BYTES 36       // f32 scroll position + 4 x f64
+
+// Recorder record types
+enum RecordType {
+    REC_TICK = 1,      // Published price snapshot
+    REC_KEYFRAME = 2,  // Full LED buffer
+    REC_DELTA = 3      // Changed LED runs since the previous frame record
+};
+
+struct RecordHeader {
+    uint8_t type;
+    uint16_t len;
+    uint32_t timestamp;
+};
+
+// What a frame was rendered from
+struct FrameInputs {
+    float scrollPosition;
+    double price;
+    double change1h;
+    double change1d;
+    double change24h;
+};
+
+inline void packRecordHeader(uint8_t* out, const RecordHeader& header) {
+    out[0] = header.type;
+    out[1] = (uint8_t)header.len;
+    out[2] = (uint8_t)(header.len >> 8);
+    for (int i = 0; i < 4; i++) {
+        out[3 + i] = (uint8_t)(header.timestamp >> (8 * i));
+    }
+}
+
+inline RecordHeader unpackRecordHeader(const uint8_t* in) {
+    RecordHeader header;
+    header.type = in[0];
+    header.len = in[1] | (in[2] << 8);
+    header.timestamp = in[3] | (in[4] << 8) | ((uint32_t)in[5] << 16) | ((uint32_t)in[6] << 24);
+    return header;
+}
+
+// Tick payload: the published values (changes narrowed to f32)
+inline void packTick(uint8_t* out, double price, double change1h, double change1d, double change24h) {
+    float changes[3] = {(float)change1h, (float)change1d, (float)change24h};
+    memcpy(out, &price, sizeof(double));
+    memcpy(out + sizeof(double), changes, sizeof(changes));
+}
+
+inline void unpackTick(const uint8_t* in, double& price, float* changes) {
+    memcpy(&price, in, sizeof(double));
+    memcpy(changes, in + sizeof(double), 3 * sizeof(float));
+}
+
+inline void packFrameInputs(uint8_t* out, const FrameInputs& inputs) {
+    double values[4] = {inputs.price, inputs.change1h, inputs.change1d, inputs.change24h};
+    memcpy(out, &inputs.scrollPosition, sizeof(float));
+    memcpy(out + sizeof(float), values, sizeof(values));
+}
+
+inline FrameInputs unpackFrameInputs(const uint8_t* in) {
+    FrameInputs inputs;
+    double values[4];
+    memcpy(&inputs.scrollPosition, in, sizeof(float));
+    memcpy(values, in + sizeof(float), sizeof(values));
+    inputs.price = values[0];
+    inputs.change1h = values[1];
+    inputs.change1d = values[2];
+    inputs.change24h = values[3];
+    return inputs;
+}
+
+// Largest frame record: header, render inputs and a keyframe. A delta is never larger,
+// since the encoder falls back to a keyframe once a delta would be as big.
+inline size_t maxFrameRecordBytes(size_t ledCount) {
+    return REC_HEADER_BYTES + REC_INPUT_BYTES + ledCount * 3;
+}
+
+// Longest keyframe interval that always leaves a keyframe (and its deltas) in a ring
+// of ringBytes. After an append the ring holds more than ringBytes minus one record,
+// so the last keyframe plus interval deltas must fit in that. 0 if the ring can't
+// guarantee one at all.
+inline uint16_t keyframeIntervalFor(size_t ringBytes, size_t ledCount) {
+    size_t records = ringBytes / maxFrameRecordBytes(ledCount);
+    return records >= 3 ? (uint16_t)(records - 2) : 0;
+}
+
+// Ring of variable-length records over caller-owned storage, oldest evicted first.
+// Not locked; the firmware guards it with recorderMutex.
+struct RecordRing {
+    uint8_t* buffer;
+    size_t capacity;
+    size_t head;        // Next write position
+    size_t tail;        // Oldest record
+    size_t used;
+    uint32_t records;
+    uint32_t evicted;
+    
+    RecordRing(uint8_t* storage, size_t bytes)
+        : buffer(storage), capacity(bytes), head(0), tail(0), used(0), records(0), evicted(0) {}
+    
+    // Copy bytes into the ring at pos, wrapping at the end
+    void writeAt(size_t pos, const uint8_t* data, size_t len) {
+        size_t first = len < capacity - pos ? len : capacity - pos;
+        memcpy(buffer + pos, data, first);
+        memcpy(buffer, data + first, len - first);
+    }
+    
+    // Copy bytes out starting offset bytes after the oldest record, wrapping at the end
+    void read(size_t offset, uint8_t* data, size_t len) const {
+        size_t pos = (tail + offset) % capacity;
+        size_t first = len < capacity - pos ? len : capacity - pos;
+        memcpy(data, buffer + pos, first);
+        memcpy(data + first, buffer, len - first);
+    }
+    
+    // Append one record, evicting the oldest records to make room. Returns false if
+    // it could never fit.
+    bool append(uint8_t type, uint32_t timestamp, const uint8_t* payload, uint16_t len) {
+        size_t total = REC_HEADER_BYTES + len;
+        if (total > capacity) {
+            return false;
+        }
+        while (capacity - used < total) {
+            uint8_t header[REC_HEADER_BYTES];
+            read(0, header, REC_HEADER_BYTES);
+            size_t oldest = REC_HEADER_BYTES + unpackRecordHeader(header).len;
+            tail = (tail + oldest) % capacity;
+            used -= oldest;
+            evicted++;
+        }
+        
+        uint8_t header[REC_HEADER_BYTES];
+        packRecordHeader(header, {type, len, timestamp});
+        writeAt(head, header, REC_HEADER_BYTES);
+        writeAt((head + REC_HEADER_BYTES) % capacity, payload, len);
+        head = (head + total) % capacity;
+        used += total;
+        records++;
+        return true;
+    }
+};
+
+// Delta/keyframe encoder for RGB frames. previous holds the last frame that made it
+// into the recording, so only call committed() once a record is actually stored: a
+// dropped record then doesn't leave later deltas pointing at a frame nobody has.
+struct FrameEncoder {
+    uint8_t* previous;          // ledCount x RGB, caller-owned
+    size_t ledCount;
+    uint16_t keyframeInterval;  // Full frame every N stored frames
+    uint16_t sinceKeyframe;
+    
+    FrameEncoder(uint8_t* previousFrame, size_t leds, uint16_t interval)
+        : previous(previousFrame), ledCount(leds), keyframeInterval(interval), sinceKeyframe(interval) {}
+    
+    // Encode frame into out (room for ledCount x 3 bytes). Returns the pixel payload
+    // length and sets type, or returns 0 if nothing changed.
+    size_t encode(const uint8_t* frame, uint8_t* out, uint8_t& type) const {
+        const size_t frameBytes = ledCount * 3;
+        size_t len = 0;
+        bool keyframe = sinceKeyframe >= keyframeInterval;
+        
+        for (size_t i = 0; i < ledCount && !keyframe; ) {
+            if (memcmp(frame + i * 3, previous + i * 3, 3) == 0) {
+                i++;
+                continue;
+            }
+            // Start a run of changed LEDs
+            size_t start = i;
+            while (i < ledCount && i - start < 255 && memcmp(frame + i * 3, previous + i * 3, 3) != 0) {
+                i++;
+            }
+            size_t count = i - start;
+            if (len + 3 + count * 3 >= frameBytes) {
+                keyframe = true;  // Delta would be no smaller than a keyframe
+                break;
+            }
+            out[len++] = (uint8_t)start;
+            out[len++] = (uint8_t)(start >> 8);
+            out[len++] = (uint8_t)count;
+            memcpy(out + len, frame + start * 3, count * 3);
+            len += count * 3;
+        }
+        
+        if (keyframe) {
+            memcpy(out, frame, frameBytes);
+            type = REC_KEYFRAME;
+            return frameBytes;
+        }
+        type = REC_DELTA;
+        return len;
+    }
+    
+    // The record encode() produced for frame was stored
+    void committed(const uint8_t* frame, uint8_t type) {
+        memcpy(previous, frame, ledCount * 3);
+        sinceKeyframe = type == REC_KEYFRAME ? 0 : sinceKeyframe + 1;
+    }
+};
+
+// Apply a frame record's pixel payload (after the render inputs) to frame.
+// Returns false for a malformed record.
+inline bool applyFramePixels(uint8_t type, const uint8_t* pixels, size_t len, uint8_t* frame, size_t ledCount) {
+    if (type == REC_KEYFRAME) {
+        if (len != ledCount * 3) {
+            return false;
+        }
+        memcpy(frame, pixels, len);
+        return true;
+    }
+    if (type != REC_DELTA) {
+        return false;
+    }
+    for (size_t pos = 0; pos < len; ) {
+        if (len - pos < 3) {
+            return false;
+        }
+        size_t start = pixels[pos] | (pixels[pos + 1] << 8);
+        size_t count = pixels[pos + 2];
+        pos += 3;
+        if (start + count > ledCount || len - pos < count * 3) {
+            return false;
+        }
+        memcpy(frame + start * 3, pixels + pos, count * 3);
+        pos += count * 3;
+    }
+    return true;
+}
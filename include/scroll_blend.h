@@ -0,0 +1,40 @@
+#pragma once
+
+// Sub-pixel compositing of the scroll strip onto the LED buffer. Templated on the
+// matrix size and pixel type so the native benchmark (test/test_frame_cost) can run
+// the same loop over walls of any size without FastLED.
+
+#include <stdint.h>
+
+// Composite an RGB565 strip onto leds. The strip is Width + 1 pixels wide, drawn one
+// pixel right of the text's integer offset; each column is a linear blend of the
+// text at floor(position) and floor(position) + 1, weighted by fraction.
+// index maps (x, y) to a leds[] position. Pixel needs a Pixel(r, g, b) constructor.
+template <int Width, int Height, typename Pixel>
+void blendScrollStrip(const uint16_t* buffer, int16_t stripHeight, int16_t top, float fraction,
+                      const uint16_t (*index)[Width], Pixel* leds) {
+    const int16_t stride = Width + 1;
+    const uint16_t rightWeight = (uint16_t)(fraction * 256.0f);
+    const uint16_t leftWeight = 256 - rightWeight;
+    
+    for (int16_t row = 0; row < stripHeight; row++) {
+        if (top + row < 0 || top + row >= Height) {
+            continue;
+        }
+        const uint16_t* line = buffer + row * stride;
+        const uint16_t* rowIndex = index[top + row];
+        for (int16_t x = 0; x < Width; x++) {
+            uint16_t a = line[x + 1];  // Text at the integer offset
+            uint16_t b = line[x];      // Same text one pixel further right
+            if ((a | b) == 0) {
+                leds[rowIndex[x]] = Pixel(0, 0, 0);
+                continue;
+            }
+            // Expand RGB565 to 8-bit channels and blend
+            uint8_t r = (((a >> 11) << 3) * leftWeight + ((b >> 11) << 3) * rightWeight) >> 8;
+            uint8_t g = ((((a >> 5) & 0x3F) << 2) * leftWeight + (((b >> 5) & 0x3F) << 2) * rightWeight) >> 8;
+            uint8_t bl = (((a & 0x1F) << 3) * leftWeight + ((b & 0x1F) << 3) * rightWeight) >> 8;
+            leds[rowIndex[x]] = Pixel(r, g, bl);
+        }
+    }
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+// Ordering of price sources for a hedged round, kept free of FreeRTOS so the native
+// tests (test/test_ranking) can check it against simulated round timing.
+
+#include <stdint.h>
+
+// What the ranking needs to know about one source at the start of a round
+struct SourceCandidate {
+    float score;              // Expected cost as primary (lower is better)
+    unsigned long msUntilDue; // Until its endpoint's nextFetch passes, 0 if due
+    bool busy;                // Still in flight from an earlier round
+};
+
+// Order the idle sources best-first into ranked and return how many there are.
+// The round timer gates polling, so a source counts as due if its nextFetch is
+// within dueTolerance: nextFetch is set from when the source was dispatched, which
+// trails the round start by the dispatch or hedge delay. Sources held back longer
+// (a server max-age) rank after every due one, as fallbacks rather than not at all.
+// Ties keep configuration order.
+template <int Count>
+int rankSources(const SourceCandidate (&sources)[Count], unsigned long dueTolerance, int* ranked) {
+    float keys[Count];
+    int tiers[Count];
+    int used = 0;
+    
+    for (int i = 0; i < Count; i++) {
+        if (sources[i].busy) {
+            continue;
+        }
+        int tier = sources[i].msUntilDue > dueTolerance ? 1 : 0;
+        // Insertion sort on (tier, score)
+        int pos = used++;
+        while (pos > 0 && (tiers[pos - 1] > tier || (tiers[pos - 1] == tier && keys[pos - 1] > sources[i].score))) {
+            ranked[pos] = ranked[pos - 1];
+            keys[pos] = keys[pos - 1];
+            tiers[pos] = tiers[pos - 1];
+            pos--;
+        }
+        ranked[pos] = i;
+        keys[pos] = sources[i].score;
+        tiers[pos] = tier;
+    }
+    return used;
+}
@@ -0,0 +1,114 @@
+# PlatformIO pre-build script: build the root CA bundle the TLS clients verify
+# server chains against (WiFiClientSecure::setCACertBundle) into ca_bundle.h.
+#
+#   custom_ca_file = certs/cacert.pem   ; PEM roots to use (default: certifi's Mozilla bundle)
+#   custom_ca_roots =                   ; keep roots whose subject contains one of these
+#       ISRG Root
+#       DigiCert Global Root
+#
+# The output is the ESP-IDF certificate bundle format: u16 root count, then per root
+# u16 subject length, u16 key length, DER subject, DER SubjectPublicKeyInfo, sorted
+# by subject (all big-endian) so the verifier can binary-search issuers.
+
+import base64
+import os
+import re
+import struct
+
+Import("env")
+
+
+def der_element(data, pos):
+    """Returns (tag, content start, end) of the DER element at pos"""
+    tag, length = data[pos], data[pos + 1]
+    pos += 2
+    if length & 0x80:
+        count = length & 0x7F
+        length = int.from_bytes(data[pos:pos + count], "big")
+        pos += count
+    return tag, pos, pos + length
+
+
+def der_children(data, start, end):
+    """Yields (tag, element start, content start, end) for each element in data[start:end]"""
+    while start < end:
+        tag, content, element_end = der_element(data, start)
+        yield tag, start, content, element_end
+        start = element_end
+
+
+def subject_and_key(cert):
+    """DER subject Name and SubjectPublicKeyInfo of a DER certificate"""
+    _, content, end = der_element(cert, 0)                       # Certificate
+    _, tbs_start, tbs_end = der_element(cert, content)           # tbsCertificate
+    fields = [cert[start:element_end] for tag, start, _, element_end in der_children(cert, tbs_start, tbs_end)
+              if tag != 0xA0]                                    # Skip the optional [0] version
+    # serialNumber, signature, issuer, validity, subject, subjectPublicKeyInfo, ...
+    return fields[4], fields[5]
+
+
+def subject_text(name):
+    """Printable attribute values of a DER Name, for matching custom_ca_roots"""
+    values = []
+    _, start, end = der_element(name, 0)
+    for _, _, set_content, set_end in der_children(name, start, end):
+        for _, _, attr_content, attr_end in der_children(name, set_content, set_end):
+            children = list(der_children(name, attr_content, attr_end))
+            if len(children) == 2:
+                _, _, value_start, value_end = children[1]
+                values.append(name[value_start:value_end].decode("utf-8", "replace"))
+    return ", ".join(values)
+
+
+def load_pem(path):
+    text = open(path).read()
+    return [base64.b64decode("".join(block.split()))
+            for block in re.findall(r"-----BEGIN CERTIFICATE-----(.*?)-----END CERTIFICATE-----", text, re.S)]
+
+
+def default_ca_file():
+    try:
+        import certifi
+    except ImportError:
+        from pip._vendor import certifi
+    return certifi.where()
+
+
+def generate():
+    path = env.GetProjectOption("custom_ca_file", "") or default_ca_file()
+    path = os.path.join(env.subst("$PROJECT_DIR"), path)
+    wanted = [line.strip() for line in env.GetProjectOption("custom_ca_roots", "").splitlines() if line.strip()]
+
+    roots = {}
+    for cert in load_pem(path):
+        subject, key = subject_and_key(cert)
+        if not wanted or any(pattern in subject_text(subject) for pattern in wanted):
+            roots[subject] = key  # Same subject twice (re-issued root): keep the last
+    if not roots:
+        raise ValueError("no CA roots from %s match custom_ca_roots" % path)
+    unmatched = [pattern for pattern in wanted if not any(pattern in subject_text(subject) for subject in roots)]
+    for pattern in unmatched:
+        print("CA bundle: no root matches %r" % pattern)
+
+    bundle = struct.pack(">H", len(roots))
+    for subject in sorted(roots):
+        bundle += struct.pack(">HH", len(subject), len(roots[subject])) + subject + roots[subject]
+    print("CA bundle: %d roots from %s, %d bytes" % (len(roots), path, len(bundle)))
+
+    out = ["// Generated by scripts/ca_bundle.py from platformio.ini - do not edit", "#pragma once", "",
+           "// %s" % "\n// ".join(subject_text(subject) for subject in sorted(roots)),
+           "const uint8_t caBundle[] = {"]
+    out += ["    %s," % ", ".join("0x%02X" % b for b in bundle[i:i + 16]) for i in range(0, len(bundle), 16)]
+    out.append("};")
+
+    directory = env.subst("$BUILD_DIR/certs")
+    header = os.path.join(directory, "ca_bundle.h")
+    content = "\n".join(out) + "\n"
+    # Only rewrite on change so an unchanged bundle doesn't force a rebuild
+    if not os.path.exists(header) or open(header).read() != content:
+        os.makedirs(directory, exist_ok=True)
+        open(header, "w").write(content)
+    env.Append(CPPPATH=[directory])
+
+
+generate()
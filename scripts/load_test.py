@@ -0,0 +1,113 @@
+#!/usr/bin/env python3
+# Web server load test: N clients hammer the ticker's pages while the display keeps
+# rendering, then frames_dropped and the tick-to-pixel counters from /api/state are
+# compared before and after. Exits non-zero if the render loop dropped frames or
+# too many requests failed.
+#
+#   python3 scripts/load_test.py btc-ticker.local --clients 20 --duration 30
+
+import argparse
+import http.client
+import json
+import sys
+import threading
+import time
+
+
+def get(host, path, timeout):
+    connection = http.client.HTTPConnection(host, 80, timeout=timeout)
+    try:
+        connection.request("GET", path)
+        response = connection.getresponse()
+        return response.status, response.read()
+    finally:
+        connection.close()
+
+
+def device_state(host):
+    status, body = get(host, "/api/state", 5)
+    if status != 200:
+        raise RuntimeError("/api/state returned %d" % status)
+    return json.loads(body)
+
+
+def client(host, paths, deadline, timeout, results, lock):
+    latencies, errors, connection = [], 0, None
+    request = 0
+    while time.time() < deadline:
+        path = paths[request % len(paths)]
+        request += 1
+        start = time.time()
+        try:
+            if connection is None:
+                connection = http.client.HTTPConnection(host, 80, timeout=timeout)
+            connection.request("GET", path)
+            response = connection.getresponse()
+            response.read()
+            if response.status != 200:
+                errors += 1
+            else:
+                latencies.append(time.time() - start)
+            if response.getheader("Connection", "").lower() == "close":
+                connection.close()
+                connection = None
+        except (OSError, http.client.HTTPException):
+            errors += 1
+            if connection is not None:
+                connection.close()
+            connection = None
+    if connection is not None:
+        connection.close()
+    with lock:
+        results["latencies"] += latencies
+        results["errors"] += errors
+
+
+def percentile(values, fraction):
+    if not values:
+        return 0.0
+    ordered = sorted(values)
+    return ordered[min(len(ordered) - 1, int(len(ordered) * fraction))]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("host", nargs="?", default="btc-ticker.local")
+    parser.add_argument("--clients", type=int, default=20)
+    parser.add_argument("--duration", type=float, default=30, help="seconds")
+    parser.add_argument("--paths", default="/api/state,/console,/resources,/")
+    parser.add_argument("--timeout", type=float, default=5)
+    parser.add_argument("--max-dropped", type=int, default=0, help="frames the display may drop during the run")
+    parser.add_argument("--max-error-rate", type=float, default=0.01)
+    args = parser.parse_args()
+
+    before = device_state(args.host)
+    results, lock = {"latencies": [], "errors": 0}, threading.Lock()
+    deadline = time.time() + args.duration
+    threads = [threading.Thread(target=client, args=(args.host, args.paths.split(","), deadline, args.timeout, results, lock))
+               for _ in range(args.clients)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    after = device_state(args.host)
+
+    served = len(results["latencies"])
+    total = served + results["errors"]
+    dropped = after["frames_dropped"] - before["frames_dropped"]
+    over_target = after["latency_over_target"] - before["latency_over_target"]
+    print("%d clients, %.0f s: %d requests (%.1f/s), %d failed" %
+          (args.clients, args.duration, total, total / args.duration, results["errors"]))
+    print("Response time: p50 %.0f ms, p99 %.0f ms, max %.0f ms" %
+          (percentile(results["latencies"], 0.5) * 1000, percentile(results["latencies"], 0.99) * 1000,
+           max(results["latencies"] or [0]) * 1000))
+    print("Display: %d frames dropped, %d ticks over the %d ms latency target (p99 now %d ms)" %
+          (dropped, over_target, after["latency_target_ms"], after["latency_p99_ms"]))
+
+    failed = dropped > args.max_dropped or (total > 0 and results["errors"] / total > args.max_error_rate)
+    print("FAIL" if failed else "PASS")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
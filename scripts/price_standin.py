@@ -0,0 +1,171 @@
+#!/usr/bin/env python3
+# Stand-in price API for exercising source ranking and hedging on a LAN. Serves
+# CoinGecko /coins/markets, /simple/price, Coinbase and Binance shaped responses on
+# one port, with configurable latency, jitter, failure rate and Cache-Control
+# max-age per source, and logs every request. With --device it also polls the
+# ticker's /api/state and reports which source won each round, exiting non-zero if
+# the fastest healthy source didn't win most of them.
+#
+#   python3 scripts/price_standin.py --port 8001 --delay coinbase=2000 --errors binance=0.5 \
+#       --device btc-ticker.local --duration 120
+#
+# Point the ticker at it in config.h (plain http:// is allowed):
+#   #define BTC_API_URL        "http://<host>:8001/coingecko/api/v3/coins/markets?vs_currency=usd&ids=bitcoin&price_change_percentage=1h"
+#   #define COINBASE_PRICE_URL "http://<host>:8001/coinbase"
+#   #define BINANCE_PRICE_URL  "http://<host>:8001/binance"
+
+import argparse
+import collections
+import http.client
+import http.server
+import json
+import random
+import socketserver
+import sys
+import threading
+import time
+
+SOURCES = ("coingecko", "coinbase", "binance")
+
+
+def parse_map(values, default):
+    """["coinbase=2000", "binance=50"] -> {source: float}"""
+    result = {source: default for source in SOURCES}
+    for value in values or []:
+        name, _, number = value.partition("=")
+        if name not in result:
+            raise SystemExit("unknown source %r (expected one of %s)" % (name, ", ".join(SOURCES)))
+        result[name] = float(number)
+    return result
+
+
+class Market:
+    """A slowly drifting price shared by every source"""
+
+    def __init__(self):
+        self.start = time.time()
+        self.open = 60000.0
+
+    def snapshot(self):
+        elapsed = time.time() - self.start
+        price = self.open * (1 + 0.002 * ((elapsed / 30) % 2 - 1))
+        return round(price, 2), (price / self.open - 1) * 100
+
+
+def body_for(source, path, market):
+    price, change = market.snapshot()
+    if source == "coingecko" and "/coins/markets" in path:
+        return json.dumps([{"id": "bitcoin", "current_price": price, "price_change_percentage_24h": change,
+                            "price_change_percentage_1h_in_currency": change / 24}])
+    if source == "coingecko":
+        return json.dumps({"bitcoin": {"usd": price, "usd_24h_change": change}})
+    if source == "coinbase":
+        return json.dumps({"open": "%.2f" % market.open, "last": "%.2f" % price, "volume": "1234.5"})
+    return json.dumps({"symbol": "BTCUSDT", "lastPrice": "%.2f" % price, "priceChangePercent": "%.3f" % change})
+
+
+def make_handler(delays, jitter, errors, max_age, market, counts, lock):
+    class Handler(http.server.BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.1"  # Keep-alive, like the real APIs
+
+        def do_GET(self):
+            source = self.path.strip("/").split("/")[0].split("?")[0]
+            if source not in SOURCES:
+                self.send_error(404)
+                return
+            delay = max(0.0, delays[source] + random.uniform(-jitter[source], jitter[source])) / 1000
+            time.sleep(delay)
+            failed = random.random() < errors[source]
+            with lock:
+                counts[source]["requests"] += 1
+                counts[source]["errors"] += failed
+            print("%s %-9s %5.0f ms %s" % (time.strftime("%H:%M:%S"), source, delay * 1000, "500" if failed else "200"),
+                  flush=True)
+            if failed:
+                self.send_error(500)
+                return
+            body = body_for(source, self.path, market).encode()
+            self.send_response(200)
+            self.send_header("Content-Type", "application/json")
+            self.send_header("Content-Length", str(len(body)))
+            if max_age[source] > 0:
+                self.send_header("Cache-Control", "max-age=%d" % max_age[source])
+            self.end_headers()
+            self.wfile.write(body)
+
+        def log_message(self, *_):
+            pass
+
+    return Handler
+
+
+def watch_device(host, duration):
+    """Polls /api/state and returns how often each source was the published one"""
+    wins, last_published = collections.Counter(), None
+    deadline = time.time() + duration
+    while time.time() < deadline:
+        try:
+            connection = http.client.HTTPConnection(host, 80, timeout=5)
+            connection.request("GET", "/api/state")
+            state = json.loads(connection.getresponse().read())
+            connection.close()
+        except (OSError, ValueError, http.client.HTTPException) as error:
+            print("device: %s" % error, flush=True)
+            time.sleep(1)
+            continue
+        # Device clock time of the last publish; moves on with every new price
+        published = state["uptime_ms"] - state["age_ms"]
+        if state["age_ms"] > 0 and state["source"] and (last_published is None or abs(published - last_published) > 250):
+            wins[state["source"]] += 1
+            last_published = published
+        time.sleep(0.5)
+    return wins
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--port", type=int, default=8001)
+    parser.add_argument("--delay", action="append", metavar="SOURCE=MS", help="base response time (default 100 ms)")
+    parser.add_argument("--jitter", action="append", metavar="SOURCE=MS", help="uniform +/- jitter (default 20 ms)")
+    parser.add_argument("--errors", action="append", metavar="SOURCE=RATE", help="fraction answered with 500")
+    parser.add_argument("--max-age", action="append", metavar="SOURCE=S", help="Cache-Control max-age to send")
+    parser.add_argument("--device", help="ticker to watch, e.g. btc-ticker.local")
+    parser.add_argument("--duration", type=float, default=120, help="seconds to watch the device")
+    parser.add_argument("--min-win-share", type=float, default=0.8, help="share of rounds the expected source must win")
+    args = parser.parse_args()
+
+    delays = parse_map(args.delay, 100)
+    jitter = parse_map(args.jitter, 20)
+    errors = parse_map(args.errors, 0)
+    max_age = parse_map(args.max_age, 0)
+    counts = {source: collections.Counter() for source in SOURCES}
+    lock = threading.Lock()
+
+    handler = make_handler(delays, jitter, errors, max_age, Market(), counts, lock)
+    server = socketserver.ThreadingTCPServer(("", args.port), handler)
+    server.daemon_threads = True
+    print("Serving %s on port %d" % (", ".join("%s (%g ms, %g%% errors)" % (s, delays[s], errors[s] * 100)
+                                               for s in SOURCES), args.port), flush=True)
+    if not args.device:
+        server.serve_forever()
+        return 0
+
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+    wins = watch_device(args.device, args.duration)
+    server.shutdown()
+
+    # Expected winner: lowest delay + timeout-weighted error rate, the device's own score
+    expected = min(SOURCES, key=lambda s: delays[s] + errors[s] * 10000)
+    total = sum(wins.values())
+    for source in SOURCES:
+        print("%-9s requests %4d  errors %4d  published %4d" %
+              (source, counts[source]["requests"], counts[source]["errors"], wins[source]))
+    share = wins[expected] / total if total else 0.0
+    print("%s published %.0f%% of %d updates (need %.0f%%)" % (expected, share * 100, total, args.min_win_share * 100))
+    failed = total == 0 or share < args.min_win_share
+    print("FAIL" if failed else "PASS")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,144 @@
+#!/usr/bin/env python3
+# Decodes a recording downloaded from /recording (format in include/recording.h):
+# rebuilds every frame from its keyframe/delta chain, checks that the chain is intact
+# and prints the ticks and per-frame checksums. --compare diffs the frames of two
+# recordings of the same ticks (e.g. before and after a rendering change), and --dump
+# writes each frame as a PPM image for inspection. Exits non-zero on a broken chain
+# or, with --compare, on any differing frame.
+#
+#   curl -o ticker.rec http://btc-ticker.local/recording
+#   python3 scripts/replay_recording.py ticker.rec
+#   python3 scripts/replay_recording.py ticker.rec --compare baseline.rec
+
+import argparse
+import os
+import struct
+import sys
+
+REC_VERSION = 2
+REC_TICK, REC_KEYFRAME, REC_DELTA = 1, 2, 3
+INPUTS = struct.Struct("<fdddd")  # scroll position, price, 1h/1d/24h change
+
+
+def checksum(frame):
+    # Same FNV-1a variant runReplay logs for rendered ticks
+    value = 2166136261
+    for i in range(0, len(frame), 3):
+        value = ((value ^ frame[i] ^ (frame[i + 1] << 8) ^ (frame[i + 2] << 16)) * 16777619) & 0xFFFFFFFF
+    return value
+
+
+def apply_pixels(kind, pixels, frame):
+    if kind == REC_KEYFRAME:
+        if len(pixels) != len(frame):
+            return False
+        frame[:] = pixels
+        return True
+    pos = 0
+    while pos < len(pixels):
+        if len(pixels) - pos < 3:
+            return False
+        start, count = struct.unpack_from("<HB", pixels, pos)
+        pos += 3
+        if (start + count) * 3 > len(frame) or len(pixels) - pos < count * 3:
+            return False
+        frame[start * 3:(start + count) * 3] = pixels[pos:pos + count * 3]
+        pos += count * 3
+    return True
+
+
+def decode(path):
+    """Returns (leds, width, height, ticks, frames, errors); frames are (timestamp, inputs, bytes)."""
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) < 9 or data[:4] != b"BTCR":
+        raise ValueError("%s: not a ticker recording" % path)
+    version, leds, width, height = struct.unpack_from("<BHBB", data, 4)
+    if version != REC_VERSION:
+        raise ValueError("%s: recording version %d, expected %d" % (path, version, REC_VERSION))
+
+    ticks, frames, errors = [], [], []
+    frame, have_keyframe = bytearray(leds * 3), False
+    pos = 9
+    while pos + 7 <= len(data):
+        kind, length, timestamp = struct.unpack_from("<BHI", data, pos)
+        payload = data[pos + 7:pos + 7 + length]
+        pos += 7 + length
+        if len(payload) < length:
+            errors.append("%d: truncated record" % timestamp)
+            break
+        if kind == REC_TICK:
+            price, c1h, c1d, c24h = struct.unpack_from("<dfff", payload)
+            ticks.append((timestamp, price, c1h, c1d, c24h))
+            continue
+        if kind not in (REC_KEYFRAME, REC_DELTA) or length < INPUTS.size:
+            errors.append("%d: bad record type %d / length %d" % (timestamp, kind, length))
+            continue
+        if kind == REC_DELTA and not have_keyframe:
+            continue  # Its keyframe was evicted from the ring before the download
+        if not apply_pixels(kind, payload[INPUTS.size:], frame):
+            errors.append("%d: malformed frame record" % timestamp)
+            have_keyframe = False
+            continue
+        have_keyframe = True
+        frames.append((timestamp, INPUTS.unpack_from(payload), bytes(frame)))
+    return leds, width, height, ticks, frames, errors
+
+
+def write_ppm(path, frame, width, height):
+    # Frames are in leds[] order; the panel mapping isn't known here, so rows of `width`
+    with open(path, "wb") as f:
+        f.write(b"P6 %d %d 255\n" % (width, height))
+        f.write(frame[:width * height * 3])
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("recording")
+    parser.add_argument("--compare", metavar="REC", help="recording to diff frames against")
+    parser.add_argument("--dump", metavar="DIR", help="write every frame as DIR/frame_NNNNN.ppm")
+    parser.add_argument("--quiet", action="store_true", help="summary only")
+    args = parser.parse_args()
+
+    leds, width, height, ticks, frames, errors = decode(args.recording)
+    if not args.quiet:
+        for timestamp, price, c1h, c1d, c24h in ticks:
+            print("%10d tick  %.2f  1H %+.1f%%  1D %+.1f%%  24H %+.1f%%" % (timestamp, price, c1h, c1d, c24h))
+        for timestamp, inputs, frame in frames:
+            print("%10d frame scroll %.2f  price %.0f  checksum %08x" % (timestamp, inputs[0], inputs[1], checksum(frame)))
+    for error in errors:
+        print("ERROR %s" % error)
+    print("%s: %dx%d, %d LEDs, %d ticks, %d frames, %d errors" %
+          (args.recording, width, height, leds, len(ticks), len(frames), len(errors)))
+
+    if args.dump:
+        os.makedirs(args.dump, exist_ok=True)
+        for n, (_, _, frame) in enumerate(frames):
+            write_ppm(os.path.join(args.dump, "frame_%05d.ppm" % n), frame, width, height)
+
+    failed = bool(errors)
+    if args.compare:
+        other_leds, _, _, _, other_frames, other_errors = decode(args.compare)
+        if other_leds != leds:
+            print("FAIL: %d LEDs vs %d" % (leds, other_leds))
+            return 1
+        # Pair frames by their render inputs so differently trimmed rings still line up
+        baseline = {inputs: frame for _, inputs, frame in other_frames}
+        paired = differing = 0
+        for timestamp, inputs, frame in frames:
+            if inputs not in baseline:
+                continue
+            paired += 1
+            if baseline[inputs] != frame:
+                differing += 1
+                changed = sum(frame[i:i + 3] != baseline[inputs][i:i + 3] for i in range(0, len(frame), 3))
+                print("%10d frame differs: %d LEDs" % (timestamp, changed))
+        print("compare: %d frames paired, %d differ" % (paired, differing))
+        failed = failed or bool(other_errors) or differing > 0
+
+    print("FAIL" if failed else "PASS")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,125 @@
+# PlatformIO pre-build script: compile the fonts listed in platformio.ini's
+# custom_fonts into font_registry.h, keeping only the glyphs in custom_font_glyphs.
+#
+#   custom_fonts =
+#       FONT_TOMTHUMB TomThumb        ; <FontType id> <GFXfont name, found as <name>.h in the libraries>
+#   custom_font_glyphs = 0123456789$%+-.:
+#
+# Glyphs outside the set keep an empty table entry so the font's first..last range
+# stays contiguous; their bitmaps are dropped. The bytes saved per font are printed
+# here and at boot.
+
+import os
+import re
+
+Import("env")
+
+GLYPH_BYTES = 8  # sizeof(GFXglyph) with padding
+
+
+def strip_source(text):
+    """Drop comments and resolve #if blocks, treating undefined macros as 0"""
+    text = re.sub(r"/\*.*?\*/", "", text, flags=re.S)
+    text = re.sub(r"//[^\n]*", "", text)
+    kept, active = [], [True]
+    for line in text.splitlines():
+        directive = line.strip()
+        if directive.startswith("#ifndef"):
+            active.append(active[-1])
+        elif directive.startswith("#ifdef"):
+            active.append(False)
+        elif directive.startswith("#if"):
+            condition = directive[3:].strip(" ()")
+            active.append(active[-1] and condition.isdigit() and int(condition) != 0)
+        elif directive.startswith("#else"):
+            active[-1] = not active[-1] and active[-2]
+        elif directive.startswith("#endif"):
+            active.pop()
+        elif not directive.startswith("#") and active[-1]:
+            kept.append(line)
+    return "\n".join(kept)
+
+
+def array_body(text, name):
+    match = re.search(r"\b%s\s*\[\s*\]\s*(?:PROGMEM)?\s*=\s*\{(.*?)\}\s*;" % name, text, re.S)
+    if match is None:
+        raise ValueError("array %s not found" % name)
+    return match.group(1)
+
+
+def load_font(path, name):
+    text = strip_source(open(path).read())
+    match = re.search(r"GFXfont\s+%s\s*(?:PROGMEM)?\s*=\s*\{\s*\(\s*uint8_t\s*\*\s*\)\s*(\w+)\s*,"
+                      r"\s*\(\s*GFXglyph\s*\*\s*\)\s*(\w+)\s*,\s*(\w+)\s*,\s*(\w+)\s*,\s*(\w+)" % name, text)
+    if match is None:
+        raise ValueError("GFXfont %s not found in %s" % (name, path))
+    bitmap_name, glyph_name, first, last, y_advance = match.groups()
+    bitmap = [int(value, 0) for value in re.findall(r"0x[0-9A-Fa-f]+|\d+", array_body(text, bitmap_name))]
+    glyphs = [[int(value, 0) for value in entry.split(",")]
+              for entry in re.findall(r"\{([^{}]*)\}", array_body(text, glyph_name))]
+    return bitmap, glyphs, int(first, 0), int(last, 0), int(y_advance, 0)
+
+
+def subset_font(bitmap, glyphs, first, last, charset):
+    codes = [code for code in sorted(charset) if first <= code <= last]
+    if not codes:
+        raise ValueError("no glyphs in range 0x%02X-0x%02X" % (first, last))
+    subset_bitmap, subset_glyphs = [], []
+    for code in range(codes[0], codes[-1] + 1):
+        offset, width, height, x_advance, x_offset, y_offset = glyphs[code - first]
+        if code not in charset:
+            subset_glyphs.append([0, 0, 0, 0, 0, 0])
+            continue
+        subset_glyphs.append([len(subset_bitmap), width, height, x_advance, x_offset, y_offset])
+        subset_bitmap += bitmap[offset:offset + (width * height + 7) // 8]
+    return subset_bitmap, subset_glyphs, codes[0], codes[-1], len(codes)
+
+
+def find_header(roots, name):
+    for root in roots:
+        for directory, _, files in os.walk(root):
+            if name + ".h" in files:
+                return os.path.join(directory, name + ".h")
+    raise ValueError("%s.h not found in %s" % (name, ", ".join(roots)))
+
+
+def generate():
+    fonts = [line.split() for line in env.GetProjectOption("custom_fonts", "").splitlines() if line.strip()]
+    charset = {ord(c) for c in env.GetProjectOption("custom_font_glyphs", "")} | {ord(" ")}
+    roots = [env.subst("$PROJECT_LIBDEPS_DIR/$PIOENV"), env.subst("$PROJECT_DIR/lib")]
+
+    out = ["// Generated by scripts/subset_fonts.py from platformio.ini - do not edit", "#pragma once", ""]
+    registry = []
+    for font_id, name in fonts:
+        bitmap, glyphs, first, last, y_advance = load_font(find_header(roots, name), name)
+        subset_bitmap, subset_glyphs, subset_first, subset_last, kept = subset_font(bitmap, glyphs, first, last, charset)
+        full_bytes = len(bitmap) + GLYPH_BYTES * (last - first + 1)
+        subset_bytes = len(subset_bitmap) + GLYPH_BYTES * len(subset_glyphs)
+        print("Font %s: %d of %d glyphs, %d -> %d bytes (%d saved)" %
+              (name, kept, last - first + 1, full_bytes, subset_bytes, full_bytes - subset_bytes))
+
+        out.append("const uint8_t %sBitmaps[] PROGMEM = {%s};" % (name, ", ".join("0x%02X" % b for b in subset_bitmap) or "0"))
+        out.append("const GFXglyph %sGlyphs[] PROGMEM = {" % name)
+        out += ["    {%s},  // 0x%02X" % (", ".join(str(v) for v in glyph), subset_first + i)
+                for i, glyph in enumerate(subset_glyphs)]
+        out.append("};")
+        out.append("const GFXfont %s PROGMEM = {(uint8_t *)%sBitmaps, (GFXglyph *)%sGlyphs, 0x%02X, 0x%02X, %d};" %
+                   (name, name, name, subset_first, subset_last, y_advance))
+        out.append("")
+        registry.append("    X(%s, %s, %d, %d)" % (font_id, name, full_bytes, subset_bytes))
+
+    out.append("// X(FontType id, GFXfont, full bytes, subset bytes)")
+    out.append("#define FONT_REGISTRY(X) \\")
+    out.append(" \\\n".join(registry) if registry else "")
+
+    directory = env.subst("$BUILD_DIR/fonts")
+    path = os.path.join(directory, "font_registry.h")
+    content = "\n".join(out) + "\n"
+    # Only rewrite on change so unchanged fonts don't force a rebuild
+    if not os.path.exists(path) or open(path).read() != content:
+        os.makedirs(directory, exist_ok=True)
+        open(path, "w").write(content)
+    env.Append(CPPPATH=[directory])
+
+
+generate()
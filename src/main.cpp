@@ -7,24 +7,49 @@
 #include <FastLED_NeoMatrix.h>
 #include <Adafruit_GFX.h>
 #include <ArduinoOTA.h>
+#include <Update.h>
 #include <ESPmDNS.h>
-#include <WebServer.h>
+#include <ESPAsyncWebServer.h>
+#include <AsyncUDP.h>
 #include <esp_task_wdt.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <mbedtls/sha256.h>
+#include <mbedtls/pk.h>
+#include <mbedtls/base64.h>
+#include <mbedtls/x509_crt.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
 
-// Built-in GFX fonts - RELIABLY AVAILABLE
-#include <Fonts/TomThumb.h>  // 3x5 pixel font - numbers + letters (compact)
-
-// Additional Adafruit built-in fonts (commented until needed)
-// #include <Fonts/FreeMono9pt7b.h>      // 9pt monospace
-// #include <Fonts/FreeMonoBold9pt7b.h>  // 9pt monospace bold
-// #include <Fonts/Tiny3x3a2pt7b.h>      // 3x3 ultra tiny
+// Root CAs that server chains are verified against, generated from platformio.ini's
+// custom_ca_roots by scripts/ca_bundle.py
+#include "ca_bundle.h"
+#include "rom/miniz.h"  // ROM inflate used for gzip-compressed OTA images
 
-// External robjen/GFX_fonts collection (temporarily disabled for reliable build)
-// Will re-enable with proper include path resolution
-// #include "Font3x5FixedNum.h"     // 3x5 - **NUMBERS ONLY**
-// #include "Font5x7FixedMono.h"    // 5x7 - numbers + letters (monospace)
+// Fonts: platformio.ini's custom_fonts, cut down at build time to the glyphs the
+// firmware draws (scripts/subset_fonts.py). Builds without the generated registry
+// fall back to the full TomThumb.
+#if __has_include("font_registry.h")
+#include "font_registry.h"
+#else
+#include <Fonts/TomThumb.h>  // 3x5 pixel font - numbers + letters (compact)
+#define FONT_REGISTRY(X) X(FONT_TOMTHUMB, TomThumb, 0, 0)
+#endif
 
 #include "config.h"
+#include "frame_timing.h"
+#include "recording.h"
+#include "scroll_blend.h"
+#include "source_ranking.h"
+#include "fanout.h"
+#include "log_ring.h"
+#include "price_parsers.h"
+#include "http_response.h"
+#include "price_round.h"
 
 // WiFi Configuration defaults (can be overridden in config.h)
 #ifndef WIFI_CONNECT_TIMEOUT
@@ -39,63 +64,346 @@
 #define WIFI_RECONNECT_INTERVAL 10000 // 10 second base reconnect interval
 #endif
 
+// CoinGecko fetch mode: one coins/markets call carries the price and its 1h and 24h
+// changes, so the hourly OHLC candles are only fetched as a backfill when it goes stale.
+// 0 = simple/price for the price plus hourly OHLC for the 1h change.
+#ifndef MARKETS_FETCH
+#define MARKETS_FETCH 1
+#endif
+
+// Fetch the daily OHLC candle for the 1d change (since today's open), and hourly candles
+// when markets data is stale. 0 = no OHLC calls; the 1d change then shows the 24h change.
+#ifndef MARKETS_OHLC_BACKFILL
+#define MARKETS_OHLC_BACKFILL 1
+#endif
+
+// Price sources, raced against each other by the hedged price fetch. Override to
+// point any of them at a local stand-in server (plain http:// is accepted).
+#ifndef BTC_API_URL
+#if MARKETS_FETCH
+#define BTC_API_URL "https://pro-api.coingecko.com/api/v3/coins/markets?vs_currency=usd&ids=bitcoin&price_change_percentage=1h"
+#else
 #define BTC_API_URL "https://pro-api.coingecko.com/api/v3/simple/price?ids=bitcoin&vs_currencies=usd&include_24hr_change=true"
+#endif
+#endif
+
+#ifndef COINBASE_PRICE_URL
+#define COINBASE_PRICE_URL "https://api.exchange.coinbase.com/products/BTC-USD/stats"
+#endif
+
+#ifndef BINANCE_PRICE_URL
+#define BINANCE_PRICE_URL "https://api.binance.com/api/v3/ticker/24hr?symbol=BTCUSDT"
+#endif
+
+// TLS public-key pins, checked on top of CA verification: base64 SHA-256 of a
+// SubjectPublicKeyInfo anywhere in the chain the host presents (pin the issuing
+// intermediate so leaf rotation doesn't break it), comma-separated so the next key
+// can be listed ahead of a rotation. Empty = CA verification only.
+#ifndef PIN_COINGECKO
+#define PIN_COINGECKO ""
+#endif
+
+#ifndef PIN_COINBASE
+#define PIN_COINBASE ""
+#endif
+
+#ifndef PIN_BINANCE
+#define PIN_BINANCE ""
+#endif
+
+// LAN fan-out: one elected leader fetches and multicasts snapshots, followers render
+// them and skip their own API calls (0 = every device fetches for itself)
+#ifndef FANOUT_ENABLED
+#define FANOUT_ENABLED 0
+#endif
+
+#define FANOUT_GROUP IPAddress(239, 255, 42, 42)
+#define FANOUT_PORT 4242
+#define FANOUT_HEARTBEAT 1000        // Leader re-sends its snapshot at least this often (ms)
+#define FANOUT_LEADER_TIMEOUT 3500   // Followers take over after this much silence (ms)
+#define FANOUT_STALE_AFTER 30000     // ... or once the leader's price has been this old for as long (ms)
+#define FANOUT_TASK_STACK 3072
+
+// Hedged price fetching: if the primary source hasn't answered within its recent p90,
+// the runner-up is fired on a second lane and whichever answers first is used
+#ifndef PRICE_HEDGING
+#define PRICE_HEDGING 1
+#endif
+
+#define PRICE_LANES 2                // Concurrent price requests (primary + hedge)
+#define SOURCE_LATENCY_SAMPLES 16    // Recent response times kept per source
+#define HEDGE_MIN_DELAY 150          // Never hedge sooner than this (ms)
+#define HEDGE_DEFAULT_DELAY 1000     // Hedge delay until a source has latency history (ms)
+#define PRICE_DUE_TOLERANCE (UPDATE_INTERVAL / 2)  // Source still due this round if its nextFetch is this close
+#define OHLC_HOURLY_URL "https://pro-api.coingecko.com/api/v3/coins/bitcoin/ohlc?vs_currency=usd&days=1&interval=hourly"
+#define OHLC_DAILY_URL "https://pro-api.coingecko.com/api/v3/coins/bitcoin/ohlc?vs_currency=usd&days=1&interval=daily"
+
+// OHLC refresh intervals, derived from each endpoint's candle granularity.
+// The hourly close only changes once per hour and the daily open once per day;
+// polling a fraction of the granularity bounds how late a new candle is noticed.
+#ifndef OHLC_HOURLY_REFRESH
+#define OHLC_HOURLY_REFRESH 300000    // 1h candles: refresh every 5 minutes
+#endif
+
+#ifndef OHLC_DAILY_REFRESH
+#define OHLC_DAILY_REFRESH 1800000    // 1d candles: refresh every 30 minutes
+#endif
+
+#ifndef FETCH_STATS_INTERVAL
+#define FETCH_STATS_INTERVAL 3600000  // Log request/parse statistics hourly
+#endif
+
+// Task stack sizes (bytes) - see /resources for right-sizing recommendations
+#ifndef PRICE_TASK_STACK
+#define PRICE_TASK_STACK 8192
+#endif
+
+#ifndef OHLC_TASK_STACK
+#define OHLC_TASK_STACK 8192
+#endif
+
+#ifndef PRICE_LANE_STACK
+#define PRICE_LANE_STACK 8192        // Each lane runs its own TLS client
+#endif
+
+#define MONITOR_TASK_STACK 3072
+
+#ifdef CONFIG_ARDUINO_LOOP_STACK_SIZE
+#define LOOP_TASK_STACK CONFIG_ARDUINO_LOOP_STACK_SIZE
+#else
+#define LOOP_TASK_STACK 8192
+#endif
+
+// Resource monitoring
+#ifndef RESOURCE_SAMPLE_INTERVAL
+#define RESOURCE_SAMPLE_INTERVAL 10000    // Heap/stack sample period (ms)
+#endif
+
+#ifndef RESOURCE_REPORT_INTERVAL
+#define RESOURCE_REPORT_INTERVAL 3600000  // Serial right-sizing report period (ms)
+#endif
+
+#define RESOURCE_HISTORY 60               // Samples kept in the ring (10 minutes at default rate)
+#define STACK_SAFETY_MARGIN 1024          // Minimum headroom added to observed peak stack usage
+#define TLS_MIN_FREE_BLOCK 24576          // Contiguous heap a TLS handshake needs (mbedTLS in/out buffers)
+#define TLS_BENCH_MAX_ROUNDS 20           // Handshakes per host and mode for POST /tlsbench
+#define TLS_BENCH_TASK_STACK 8192         // One-off benchmark task; TLS-sized like the fetch tasks
+#define RESOURCE_LINE_BYTES 128           // Longest /resources report line
+#define RESOURCE_LINE_BUSY -2             // resourceReportLine() couldn't get resourceMutex
+
+// Heap allocation accounting. Needs malloc/calloc/realloc wrapped at link time
+// (-Wl,--wrap=..., set alongside -DALLOC_COUNTING=1 by platformio.ini's esp32dev_alloc env).
+#ifndef ALLOC_COUNTING
+#define ALLOC_COUNTING 0
+#endif
+
+#ifndef ALLOC_STRICT
+#define ALLOC_STRICT 0                    // Abort on a steady-state allocation (soak testing)
+#endif
+
+#define ALLOC_WARMUP 120000               // Steady state is checked from this long after boot (ms)
+
+// Preallocated fetch arenas: responses are read and parsed in place, never into Strings
+#define PRICE_BODY_BYTES 2048             // Per price lane; CoinGecko's /coins/markets (~800 B) is the largest
+#define OHLC_BODY_BYTES 4096              // One day of 30-minute candles
+#define OHLC_DOC_BYTES 6144               // JSON pool for that candle array
+#define HTTP_REQUEST_BYTES 512
+#define ETAG_BYTES 72
+
+// Pull OTA (device downloads firmware from a local HTTP server)
+#ifndef OTA_BRIGHTNESS
+#define OTA_BRIGHTNESS 16        // Dim progress bar keeps power draw low during flash writes
+#endif
+
+// Shared secret a pull OTA request must carry in its X-OTA-Token header. A custom header
+// can't be sent cross-origin without a CORS preflight, so a web page can't forge the POST.
+// Empty = /ota disabled.
+#ifndef OTA_TOKEN
+#define OTA_TOKEN ""
+#endif
+
+#define OTA_CHUNK_SIZE 1024      // Download read size
+#define OTA_STALL_TIMEOUT 5000   // Drop and resume a transfer that stalls this long (ms)
+#define OTA_MAX_ATTEMPTS 10      // Resume attempts before giving up
+#define OTA_PULL_TASK_STACK 8192
+#define OTA_POLL_INTERVAL 250    // ArduinoOTA.handle() period; each call mallocs a 1460-byte UDP buffer (ms)
+
+// Binary recorder for price ticks and (optionally) rendered frames, in separate rings
+// so frames can't evict ticks
+#ifndef RECORDER_BYTES
+#define RECORDER_BYTES 16384     // Tick ring size
+#endif
+
+#ifndef REC_FRAME_BYTES
+#define REC_FRAME_BYTES 16384    // Frame ring size
+#endif
+
+#ifndef REC_FRAME_INTERVAL
+#define REC_FRAME_INTERVAL 250   // Record at most one frame per this many ms
+#endif
+
+#define REC_PAUSE_TIMEOUT 10000  // Download pause expires if the client goes away
 
-// Font selection enum for easy switching
+// Font selection: the built-in 6x8 font plus every registered font
 enum FontType {
   FONT_BUILTIN,           // 6x8 built-in font (default)
-  FONT_TOMTHUMB,          // 3x5 - numbers + letters (compact)
-//   // NUMBERS ONLY fonts (ultra compact for price display)
-//   FONT_2X5_NUM,           // 2x5 - **NUMBERS ONLY** (ultra compact)
-//   FONT_3X5_NUM,           // 3x5 - **NUMBERS ONLY** (2 variants: rounder/squarer)
-//   FONT_3X7_NUM,           // 3x7 - **NUMBERS ONLY** (rounder/squarer variants)
-//   // FULL CHARACTER SET fonts (numbers + letters)
-//   FONT_4X5_FIXED,         // 4x5 - numbers + letters (proportional, compact)
-//   FONT_4X7_FIXED,         // 4x7 - numbers + letters (proportional)
-//   FONT_5X5_FIXED,         // 5x5 - numbers + letters (proportional)
-//   FONT_5X7_FIXED,         // 5x7 - numbers + letters (proportional)
-//   FONT_5X7_MONO           // 5x7 - numbers + letters (monospace, best readability)
+#define FONT_ENUM(id, font, fullBytes, subsetBytes) id,
+  FONT_REGISTRY(FONT_ENUM)
+#undef FONT_ENUM
+  FONT_COUNT
 };
 
-// Scroll state structure for independent scrolling text management
-struct ScrollState {
-    int16_t offset;
-    unsigned long lastUpdate;
-    unsigned long speed;
-    
-    ScrollState(int16_t startOffset = 32, unsigned long scrollSpeed = 100) 
-        : offset(startOffset), lastUpdate(0), speed(scrollSpeed) {}
-    
-    bool shouldUpdate() {
-        return (millis() - lastUpdate) > speed;
-    }
-    
-    void update() {
-        lastUpdate = millis();
-        offset--;
-    }
-    
-    void reset(int16_t resetOffset = 32) {
-        offset = resetOffset;
-    }
+// GFXfont for each FontType (NULL = built-in)
+const GFXfont* const fontTable[FONT_COUNT] = {
+    NULL,
+#define FONT_ENTRY(id, font, fullBytes, subsetBytes) &font,
+    FONT_REGISTRY(FONT_ENTRY)
+#undef FONT_ENTRY
 };
 
+// Font per widget (must be registered in platformio.ini's custom_fonts)
+#ifndef PRICE_FONT
+#define PRICE_FONT FONT_TOMTHUMB
+#endif
+
+#ifndef CHANGES_FONT
+#define CHANGES_FONT FONT_TOMTHUMB
+#endif
+
+#ifndef STATUS_FONT
+#define STATUS_FONT FONT_TOMTHUMB
+#endif
+
+// Frame pacing target for loop() rendering
+#ifndef TARGET_FPS
+#define TARGET_FPS 60
+#endif
+
+// Sub-pixel scrolling: blend the two nearest integer positions for smooth motion (0 to disable)
+#ifndef SCROLL_SUBPIXEL
+#define SCROLL_SUBPIXEL 1
+#endif
+
+#define SCROLL_STRIP_HEIGHT 8  // Rows covered by one scrolling text line
+
+// Matrix geometry: MATRIX_WIDTH x MATRIX_HEIGHT built from MATRIX_TILES_X x MATRIX_TILES_Y
+// identical panels (e.g. 128x32 = 4x2 tiles of 32x16)
+#ifndef NUM_LEDS
+#define NUM_LEDS (MATRIX_WIDTH * MATRIX_HEIGHT)
+#endif
+
+#ifndef MATRIX_TILES_X
+#define MATRIX_TILES_X 1
+#endif
+
+#ifndef MATRIX_TILES_Y
+#define MATRIX_TILES_Y 1
+#endif
+
+#ifndef MATRIX_PANEL_LAYOUT
+#define MATRIX_PANEL_LAYOUT (NEO_MATRIX_BOTTOM + NEO_MATRIX_RIGHT + NEO_MATRIX_COLUMNS + NEO_MATRIX_ZIGZAG)
+#endif
+
+#ifndef MATRIX_TILE_LAYOUT
+#define MATRIX_TILE_LAYOUT (NEO_TILE_TOP + NEO_TILE_LEFT + NEO_TILE_ROWS + NEO_TILE_PROGRESSIVE)
+#endif
+
+#define TILE_WIDTH (MATRIX_WIDTH / MATRIX_TILES_X)
+#define TILE_HEIGHT (MATRIX_HEIGHT / MATRIX_TILES_Y)
+
+// Parallel outputs: the chained panels are split into LED_OUTPUTS equal runs, each on
+// its own data pin (LED_PIN, LED_PIN_2 ...). The ESP32 RMT driver clocks all pins out
+// at once, so refresh time follows the longest run rather than the whole wall.
+#ifndef LED_OUTPUTS
+#define LED_OUTPUTS 1
+#endif
+
+#define LEDS_PER_OUTPUT (NUM_LEDS / LED_OUTPUTS)
+
+#if (LED_OUTPUTS > 1 && !defined(LED_PIN_2)) || (LED_OUTPUTS > 2 && !defined(LED_PIN_3)) || (LED_OUTPUTS > 3 && !defined(LED_PIN_4))
+#error "Define LED_PIN_2 ... LED_PIN_n for each extra output"
+#endif
+
+static_assert(NUM_LEDS == MATRIX_WIDTH * MATRIX_HEIGHT, "NUM_LEDS must equal MATRIX_WIDTH * MATRIX_HEIGHT");
+static_assert(MATRIX_WIDTH % MATRIX_TILES_X == 0 && MATRIX_HEIGHT % MATRIX_TILES_Y == 0, "Matrix must divide evenly into tiles");
+static_assert(MATRIX_WIDTH <= 255 && MATRIX_HEIGHT <= 255, "FastLED_NeoMatrix limits each dimension to 255");
+static_assert(LED_OUTPUTS >= 1 && LED_OUTPUTS <= 4, "LED_OUTPUTS must be 1-4");
+static_assert((MATRIX_TILES_X * MATRIX_TILES_Y) % LED_OUTPUTS == 0, "Each output must drive a whole number of tiles");
+
+// Ticker rows: price centred in the top half, changes scroll in the bottom half
+#define PRICE_BASELINE (MATRIX_HEIGHT / 4 + 3)
+#define CHANGES_BASELINE (MATRIX_HEIGHT * 3 / 4 + 2)
+
+// Tick-to-pixel latency: fetch response arrival to the new price being shown
+#ifndef LATENCY_TARGET_MS
+#define LATENCY_TARGET_MS 50   // Latencies above this are counted and logged
+#endif
+
+#define LATENCY_BUCKETS 12     // Log2 buckets: <1ms, 1-2ms, 2-4ms ... >=1024ms
+
+// Deferred logging: LOG_* call sites queue a format pointer plus raw arguments and
+// LogTask formats them to Serial and the web console. Levels above LOG_LEVEL compile out.
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#define LOG_DRAIN_INTERVAL 20  // ms between LogTask drains
+#define LOG_TASK_STACK 3072
+
+#define LOG_ERROR(...) do { if (LOG_LEVEL >= LOG_LEVEL_ERROR) logDeferred(LOG_LEVEL_ERROR, __VA_ARGS__); } while (0)
+#define LOG_WARN(...) do { if (LOG_LEVEL >= LOG_LEVEL_WARN) logDeferred(LOG_LEVEL_WARN, __VA_ARGS__); } while (0)
+#define LOG_INFO(...) do { if (LOG_LEVEL >= LOG_LEVEL_INFO) logDeferred(LOG_LEVEL_INFO, __VA_ARGS__); } while (0)
+#define LOG_DEBUG(...) do { if (LOG_LEVEL >= LOG_LEVEL_DEBUG) logDeferred(LOG_LEVEL_DEBUG, __VA_ARGS__); } while (0)
+
 // Forward declarations
 void connectToWiFi();
 void setupOTA();
 void setupWebServer();
 void addToConsoleBuffer(const String& message);
+void addToConsoleBuffer(const char* message);
+void appendToConsole(unsigned long timestamp, const char* message);
+void logTask(void *pvParameters);
 void fetchBTCPriceTask(void *pvParameters);
+void priceLaneTask(void *pvParameters);
 void fetchOHLCDataTask(void *pvParameters);
+void runTlsBenchmark(int rounds);
+void tlsBenchTask(void *pvParameters);
 void suspendHttpTasks();
 void resumeHttpTasks();
+void resourceMonitorTask(void *pvParameters);
+void fanoutTask(void *pvParameters);
+void broadcastSnapshot();
+void sendSnapshot();
+size_t fillResourceChunk(struct ReportCursor& cursor, uint8_t* buffer, size_t maxLen);
+size_t fillConsoleChunk(struct ConsoleCursor& cursor, uint8_t* buffer, size_t maxLen, size_t index,
+                        const char* prefix, const char* suffix);
+bool startOtaPull(const String& url, const String& sha256);
+void showOtaProgress(unsigned int percent, CRGB color);
 
 // Text printing function declarations
 void printText(int16_t x, int16_t y, const char* text, FontType fontType = FONT_BUILTIN, uint16_t color = 0xFFFF);
 void printTextCentered(int16_t width, int16_t y, const char* text, FontType fontType = FONT_BUILTIN, uint16_t color = 0xFFFF);
 void printScrollingText(int16_t y, const char* text, ScrollState& scrollState, FontType fontType = FONT_BUILTIN, uint16_t color = 0xFFFF);
 void updateScrollingText(int16_t y, const char* text, ScrollState& scrollState, int16_t resetOffset, FontType fontType = FONT_BUILTIN, uint16_t color = 0xFFFF);
-void updateMultiColorScrollingText(int16_t y, ScrollState& scrollState, FontType fontType);
+void updateMultiColorScrollingText(int16_t y, ScrollState& scrollState, FontType fontType, unsigned long now);
+void renderTicker(ScrollState& scrollState, unsigned long now);
+void recordTick();
+void recordFrame(unsigned long timestamp);
+void runReplay();
+size_t fillRecordingChunk(uint8_t* buffer, size_t maxLen, size_t index);
+void recordTickLatency(unsigned long latencyMicros);
+unsigned long latencyPercentileMs(int percentile);
+long steadyAllocations();
+void setMatrixFont(FontType fontType);
+template <uint8_t PIN> void addLedOutput(int output);
+void buildLedIndex();
+void applyFont(Adafruit_GFX& gfx, FontType fontType);
+void reportFontSizes();
 
 // LED Array
 CRGB leds[NUM_LEDS];
@@ -107,12 +415,104 @@ double btc24hChange = 0.0;
 double btc1hChange = 0.0;
 // double btc4hChange = 0.0;
 double btc1dChange = 0.0;
+unsigned long lastPriceUpdate = 0;  // millis() when currentBTCPrice last changed
 bool wifiConnected = false;
 
+// Values the display renders from; copied from the shared globals when a fetch
+// task signals a new tick, so loop() never reads them without the mutex
+struct PriceSnapshot {
+    double price;
+    double change1h;
+    double change1d;
+    double change24h;
+};
+
+PriceSnapshot renderSnapshot = {0.0, 0.0, 0.0, 0.0};
+
+// Tick publication (guarded by priceMutex)
+unsigned long tickReceivedAt = 0;  // micros() when the oldest unrendered response arrived
+bool tickPending = false;
+
+// Log2-bucketed tick-to-pixel latency histogram (written by loop() only)
+struct LatencyHistogram {
+    uint32_t counts[LATENCY_BUCKETS];
+    uint32_t samples;
+    uint32_t overTarget;
+    uint32_t maxMicros;
+};
+
+LatencyHistogram tickLatency = {};
+
+// Tick and frame rings (see RecordRing in recording.h)
+uint8_t tickRingBuffer[RECORDER_BYTES];
+uint8_t frameRingBuffer[REC_FRAME_BYTES];
+
+// Keyframe often enough that the frame ring always holds one to decode from
+const uint16_t REC_KEYFRAME_INTERVAL = keyframeIntervalFor(REC_FRAME_BYTES, NUM_LEDS);
+
+struct Recorder {
+    RecordRing ticks;
+    RecordRing frames;
+    bool framesEnabled;         // Also record leds[] after show(), every REC_FRAME_INTERVAL
+    unsigned long pausedUntil;  // millis() until which recording is paused
+};
+
+Recorder recorder = {RecordRing(tickRingBuffer, RECORDER_BYTES), RecordRing(frameRingBuffer, REC_FRAME_BYTES), false, 0};
+SemaphoreHandle_t recorderMutex;
+bool replayRequested = false;
+TaskHandle_t tlsBenchTaskHandle = NULL;  // Set while a /tlsbench run is in progress
+
+
+LogRing logRing;
+TaskHandle_t logTaskHandle = NULL;
+
+// Queue a log record. Formatting happens later on LogTask, so the call site only
+// claims a slot and copies its arguments.
+template <typename... Args>
+void logDeferred(uint8_t level, const char* format, Args... args) {
+    logRing.push(level, millis(), format, args...);
+}
+
 // OTA state management
 bool otaInProgress = false;
 bool httpTasksSuspended = false;
 
+// Pull OTA decoder stages: format detection, gzip header fields, then raw inflate
+enum OtaStage {
+    OTA_STAGE_DETECT,
+    OTA_STAGE_RAW,           // Uncompressed .bin, written as received
+    OTA_STAGE_GZIP_FIXED,
+    OTA_STAGE_GZIP_EXTRA,
+    OTA_STAGE_GZIP_NAME,
+    OTA_STAGE_GZIP_COMMENT,
+    OTA_STAGE_GZIP_HCRC,
+    OTA_STAGE_INFLATE,
+    OTA_STAGE_DONE           // Deflate stream finished, only the trailer remains
+};
+
+// State for a pull OTA; kept across reconnects so a transfer can resume mid-stream
+struct OtaPullState {
+    char url[192];
+    char expectedSha256[65];       // Hex SHA-256 of the decompressed image
+    OtaStage stage;
+    bool compressed;
+    bool failed;                   // Unrecoverable without restarting from byte 0
+    uint8_t gzipFlags;
+    uint8_t headerPos;
+    uint16_t extraRemaining;
+    tinfl_decompressor* inflator;
+    uint8_t* dict;                 // 32KB inflate window, also the output buffer
+    size_t dictOffset;
+    tinfl_status inflateStatus;
+    mbedtls_sha256_context sha;
+    size_t receivedBytes;          // Bytes downloaded (compressed)
+    size_t imageBytes;             // Bytes written to flash (decompressed)
+    int totalBytes;                // Download size, -1 until known
+};
+
+OtaPullState otaPull;
+TaskHandle_t otaPullTaskHandle = NULL;
+
 // Request state management
 bool priceRequestInProgress = false;
 bool ohlcHourlyRequestInProgress = false;
@@ -121,40 +521,338 @@ unsigned long lastPriceRequestTime = 0;
 unsigned long lastOHLCRequestTime = 0;
 const unsigned long REQUEST_TIMEOUT = 10000;  // 10 seconds timeout for requests
 
+// Per-endpoint refresh state for conditional, deduplicated fetching
+struct EndpointState {
+    const char* name;
+    const char* url;
+    const char* pins;             // Accepted TLS key pins (see PIN_COINGECKO)
+    const char* apiKey;           // Sent as x-cg-pro-api-key (CoinGecko only)
+    bool secure;                  // https:// (plain http:// lets it point at a local stand-in)
+    unsigned long baseInterval;   // Refresh interval from the data's natural granularity
+    unsigned long nextFetch;      // millis() when the endpoint is next due
+    char etag[ETAG_BYTES];        // ETag of the last parsed body, sent back as If-None-Match
+    uint32_t payloadHash;         // Hash of the last parsed body
+    char pendingEtag[ETAG_BYTES]; // ETag of the latest FETCH_NEW body, kept once it parses
+    uint32_t pendingHash;         // Its hash (see acceptPayload)
+    unsigned long respondedAt;    // micros() when the last response arrived
+    
+    // Counters for the periodic requests/CPU report
+    uint32_t requests;
+    uint32_t notModified;
+    uint32_t unchanged;
+    uint32_t parsed;
+    uint32_t parseMicros;
+    uint32_t handshakes;          // New connections (TLS handshakes for https)
+    uint32_t reusedConnections;   // Requests on a kept-alive connection
+    uint32_t handshakeMillis;
+    uint32_t handshakeMaxMillis;
+    uint32_t pinMicros;
+    
+    EndpointState(const char* endpointName, const char* endpointUrl, unsigned long interval, const char* keyPins,
+                  const char* key = COINGECKO_API_KEY)
+        : name(endpointName), url(endpointUrl), pins(keyPins), apiKey(key), secure(strncmp(endpointUrl, "https:", 6) == 0),
+          baseInterval(interval), nextFetch(0), etag(), payloadHash(0), pendingEtag(), pendingHash(0),
+          respondedAt(0), requests(0), notModified(0), unchanged(0), parsed(0), parseMicros(0),
+          handshakes(0), reusedConnections(0), handshakeMillis(0), handshakeMaxMillis(0), pinMicros(0) {}
+};
+
+enum FetchResult {
+    FETCH_FAILED,        // Transport or HTTP error
+    FETCH_NOT_MODIFIED,  // 304 - server confirmed our ETag is current
+    FETCH_UNCHANGED,     // 200 but byte-identical to the last payload
+    FETCH_NEW            // New payload to parse
+};
+
+EndpointState hourlyEndpoint("ohlc-hourly", OHLC_HOURLY_URL, OHLC_HOURLY_REFRESH, PIN_COINGECKO);
+EndpointState dailyEndpoint("ohlc-daily", OHLC_DAILY_URL, OHLC_DAILY_REFRESH, PIN_COINGECKO);
+
+// A price API adapter: conditional-fetch state, a parser for the response format,
+// and the latency/error scoreboard used to pick each round's primary
+struct PriceSource {
+    EndpointState endpoint;
+    bool (*parse)(const char* body, size_t len, double& price, double& change24h, double& change1h);  // change1h if the API has it
+    
+    uint16_t latencyMs[SOURCE_LATENCY_SAMPLES];  // Recent successful response times
+    uint8_t latencyHead;
+    uint8_t latencyCount;
+    float errorRate;         // Decaying failure rate, 0..1
+    uint32_t wins;           // Rounds this source answered first
+    uint32_t errors;
+    volatile bool inFlight;  // A lane is fetching it (possibly for an earlier round)
+};
+
+PriceSource priceSources[] = {
+    {EndpointState("coingecko", BTC_API_URL, UPDATE_INTERVAL, PIN_COINGECKO), MARKETS_FETCH ? parseCoinGeckoMarkets : parseCoinGeckoPrice},
+    {EndpointState("coinbase", COINBASE_PRICE_URL, UPDATE_INTERVAL, PIN_COINBASE, NULL), parseCoinbasePrice},
+    {EndpointState("binance", BINANCE_PRICE_URL, UPDATE_INTERVAL, PIN_BINANCE, NULL), parseBinancePrice},
+};
+const int PRICE_SOURCE_COUNT = sizeof(priceSources) / sizeof(priceSources[0]);
+
+// Work order from the price task to a fetch lane
+struct PriceRequest {
+    uint32_t round;
+    uint8_t source;
+};
+
+// Outcome posted back by a fetch lane
+struct PriceResult {
+    uint32_t round;
+    uint8_t source;
+    FetchResult fetch;
+    bool valid;                 // Parsed a price (FETCH_NEW only)
+    double price;
+    double change24h;
+    double change1h;            // NAN unless the source reports it
+    unsigned long respondedAt;  // micros() when the response arrived
+};
+
+QueueHandle_t laneRequests[PRICE_LANES];
+QueueHandle_t laneResults;
+volatile bool laneBusy[PRICE_LANES] = {false};
+SemaphoreHandle_t sourceMutex;
+const char* lastPriceSource = "";
+uint32_t hedgesFired = 0;
+uint32_t hedgeWins = 0;
+
+FanoutElection fanout(FANOUT_ENABLED);
+AsyncUDP fanoutUdp;
+uint32_t fanoutSequence = 0;
+
+// OHLC reference points; 1h/1d changes are recomputed against these on every price update
+double price1hClose = 0.0;
+double dailyOpen = 0.0;
+
 // WiFi status management
 unsigned long lastReconnectAttempt = 0;
 
 // Scroll state instances for different text lines
 ScrollState connectingScroll(0, 100);  // "Connecting..." - starts visible left, 100ms speed
-ScrollState offlineScroll(32, 150);    // "Offline" - starts from right, 150ms speed (slower)
+ScrollState offlineScroll(MATRIX_WIDTH, 150);    // "Offline" - starts from right, 150ms speed (slower)
 ScrollState changeScroll(0, 120);      // "24H: x.x%" - 120ms speed
 
-// FastLED_NeoMatrix setup for 32x16 matrix
-FastLED_NeoMatrix *matrix = new FastLED_NeoMatrix(leds, 32, 16, NEO_MATRIX_BOTTOM + NEO_MATRIX_RIGHT + NEO_MATRIX_COLUMNS + NEO_MATRIX_ZIGZAG);
+// FramePacer's time base: micros() and the loop task's notification wait
+struct TaskClock {
+    static unsigned long micros() {
+        return ::micros();
+    }
+    static bool waitForNotify(unsigned long ms) {
+        return ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(ms)) > 0;
+    }
+};
+
+FramePacer<TaskClock> framePacer(TARGET_FPS);
+
+// FastLED_NeoMatrix setup: one tile for a single panel, a tile grid for larger walls
+FastLED_NeoMatrix *matrix = new FastLED_NeoMatrix(leds, TILE_WIDTH, TILE_HEIGHT, MATRIX_TILES_X, MATRIX_TILES_Y,
+                                                  MATRIX_PANEL_LAYOUT + MATRIX_TILE_LAYOUT);
+
+// (x, y) -> leds[] index, built once from the matrix mapping so per-pixel compositing
+// is a table lookup instead of the tile/zigzag arithmetic in drawPixel()
+uint16_t ledIndex[MATRIX_HEIGHT][MATRIX_WIDTH];
+
+#if SCROLL_SUBPIXEL
+// Off-screen strip for scrolling text: one pixel wider than the matrix so the
+// left neighbour of every column is available when blending
+GFXcanvas16 scrollCanvas(MATRIX_WIDTH + 1, SCROLL_STRIP_HEIGHT);
+#endif
 
 // Task handles for non-blocking HTTP requests
 TaskHandle_t priceTaskHandle = NULL;
 TaskHandle_t ohlcTaskHandle = NULL;
+TaskHandle_t loopTaskHandle = NULL;
+TaskHandle_t monitorTaskHandle = NULL;
+TaskHandle_t priceLaneHandles[PRICE_LANES] = {NULL};
+TaskHandle_t fanoutTaskHandle = NULL;
+
+// Tasks whose stack headroom (and heap allocations) are tracked by the resource monitor
+struct MonitoredTask {
+    const char* name;
+    TaskHandle_t* handle;
+    uint32_t stackSize;      // Bytes allocated at creation
+    uint32_t minFreeStack;   // Lowest high-water mark seen (bytes)
+    bool allocFree;          // Fetch/render/log path: must not allocate in steady state
+    uint32_t allocations;    // malloc/calloc/realloc calls (ALLOC_COUNTING)
+    uint32_t steadyBaseline; // allocations when steady state began
+    uint8_t allowedDepth;    // Nesting of AllocScope on this task
+};
+
+MonitoredTask monitoredTasks[] = {
+    {"loopTask", &loopTaskHandle, LOOP_TASK_STACK, UINT32_MAX, true},
+    {"PriceTask", &priceTaskHandle, PRICE_TASK_STACK, UINT32_MAX, true},
+    {"PriceLane0", &priceLaneHandles[0], PRICE_LANE_STACK, UINT32_MAX, true},
+    {"PriceLane1", &priceLaneHandles[1], PRICE_LANE_STACK, UINT32_MAX, true},
+    {"OHLCTask", &ohlcTaskHandle, OHLC_TASK_STACK, UINT32_MAX, true},
+    {"MonitorTask", &monitorTaskHandle, MONITOR_TASK_STACK, UINT32_MAX, false},
+    {"FanoutTask", &fanoutTaskHandle, FANOUT_TASK_STACK, UINT32_MAX, false},
+    {"LogTask", &logTaskHandle, LOG_TASK_STACK, UINT32_MAX, true},
+};
+const int MONITORED_TASK_COUNT = sizeof(monitoredTasks) / sizeof(monitoredTasks[0]);
+
+#if ALLOC_COUNTING
+// The monitored task that is running, or NULL for any other task or an ISR
+MonitoredTask* currentMonitoredTask() {
+    if (xPortInIsrContext()) {
+        return NULL;
+    }
+    TaskHandle_t current = xTaskGetCurrentTaskHandle();
+    for (int i = 0; current != NULL && i < MONITORED_TASK_COUNT; i++) {
+        if (*monitoredTasks[i].handle == current) {
+            return &monitoredTasks[i];
+        }
+    }
+    return NULL;
+}
+
+// The linker routes every malloc/calloc/realloc (String, new, ArduinoJson's dynamic
+// pools, newlib) through these, which count the call against the monitored task
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+static void countAllocation() {
+    MonitoredTask* task = currentMonitoredTask();
+    if (task != NULL && task->allowedDepth == 0) {
+        __atomic_fetch_add(&task->allocations, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void* __wrap_malloc(size_t size) {
+    countAllocation();
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    countAllocation();
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    countAllocation();
+    return __real_realloc(ptr, size);
+}
+}
+#endif
+
+// Allocations the steady-state check expects on this task while in scope, such as a
+// TLS handshake after the server closed a kept-alive connection, or WiFi reconnects
+struct AllocScope {
+#if ALLOC_COUNTING
+    MonitoredTask* task;
+    AllocScope() : task(currentMonitoredTask()) {
+        if (task != NULL) {
+            task->allowedDepth++;
+        }
+    }
+    ~AllocScope() {
+        if (task != NULL) {
+            task->allowedDepth--;
+        }
+    }
+#else
+    AllocScope() {}
+#endif
+};
+
+// One periodic heap/stack sample
+struct ResourceSample {
+    unsigned long timestamp;
+    uint32_t freeHeap;
+    uint32_t largestFreeBlock;
+    uint32_t freeStack[sizeof(monitoredTasks) / sizeof(monitoredTasks[0])];
+};
+
+// Extremes over the whole uptime
+struct ResourceStats {
+    uint32_t minFreeHeap;
+    uint32_t maxFreeHeap;
+    uint32_t minLargestBlock;
+};
+
+// Where a /resources response has got to: the next line to generate and the unsent
+// rest of the current one
+struct ReportCursor {
+    int line;
+    char text[RESOURCE_LINE_BYTES];
+    size_t len;
+    size_t offset;
+    
+    ReportCursor() : line(0), len(0), offset(0) {}
+};
+
+ResourceSample resourceHistory[RESOURCE_HISTORY];
+int resourceHistoryHead = 0;
+int resourceHistoryCount = 0;
+ResourceStats resourceStats = {UINT32_MAX, 0, UINT32_MAX};
 
 // Mutex for thread-safe access to shared variables
 SemaphoreHandle_t priceMutex;
+SemaphoreHandle_t resourceMutex;
 
-// Web server for console monitoring
-WebServer server(80);
-String consoleBuffer = "";
-const int MAX_CONSOLE_BUFFER = 8192;  // 8KB buffer for console output
+// Event-driven web server for console monitoring (serviced by the AsyncTCP task, not loop())
+AsyncWebServer server(80);
+SemaphoreHandle_t consoleMutex = NULL;
+const int MAX_CONSOLE_BUFFER = 8192;  // 8KB ring for console output, oldest text overwritten
+char consoleRing[MAX_CONSOLE_BUFFER];
+size_t consoleHead = 0;               // Next write position
+size_t consoleUsed = 0;
+uint32_t consoleWritten = 0;          // Bytes ever written, so readers can tell what was overwritten
+
+// Where a console response has got to. The ring's extent is fixed when the response
+// starts, so lines appended mid-download aren't spliced into it.
+struct ConsoleCursor {
+    bool started;
+    uint32_t next;       // consoleWritten position of the next ring byte to send
+    uint32_t end;        // consoleWritten when the response started
+    size_t suffixSent;
+    
+    ConsoleCursor() : started(false), next(0), end(0), suffixSent(0) {}
+};
+
+// Per-task arenas for the fetch paths, so steady-state fetching never touches the heap
+char laneBodies[PRICE_LANES][PRICE_BODY_BYTES];
+char ohlcBody[OHLC_BODY_BYTES];
+StaticJsonDocument<OHLC_DOC_BYTES> ohlcDoc;
 
 void setup() {
     Serial.begin(115200);
     Serial.println("ESP32 LED Matrix BTC Ticker Starting...");
     
-    // Initialize FastLED
-    FastLED.addLeds<LED_TYPE, LED_PIN, COLOR_ORDER>(leds, NUM_LEDS).setCorrection(TypicalLEDStrip);
+    // Console buffer is shared with the async web server task
+    consoleMutex = xSemaphoreCreateMutex();
+    
+    // Deferred logging: LOG_* callers only queue, LogTask formats and prints
+    xTaskCreatePinnedToCore(
+        logTask,              // Task function
+        "LogTask",            // Task name
+        LOG_TASK_STACK,       // Stack size
+        NULL,                 // Parameters
+        0,                    // Priority (below everything else)
+        &logTaskHandle,       // Task handle
+        0                     // Core 0
+    );
+    
+    // Initialize FastLED - one controller per output pin
+    addLedOutput<LED_PIN>(0);
+#if LED_OUTPUTS > 1
+    addLedOutput<LED_PIN_2>(1);
+#endif
+#if LED_OUTPUTS > 2
+    addLedOutput<LED_PIN_3>(2);
+#endif
+#if LED_OUTPUTS > 3
+    addLedOutput<LED_PIN_4>(3);
+#endif
     FastLED.setBrightness(BRIGHTNESS);
     
     // Initialize matrix for text rendering
     matrix->begin();
     matrix->setBrightness(BRIGHTNESS);
+    buildLedIndex();
+    Serial.printf("Matrix %dx%d (%dx%d tiles of %dx%d), %d LEDs on %d output(s), ~%d us per refresh\n",
+                  MATRIX_WIDTH, MATRIX_HEIGHT, MATRIX_TILES_X, MATRIX_TILES_Y, TILE_WIDTH, TILE_HEIGHT,
+                  NUM_LEDS, LED_OUTPUTS, LEDS_PER_OUTPUT * 30);
+    reportFontSizes();
     
     // Clear all LEDs
     fill_solid(leds, NUM_LEDS, CRGB::Black);
@@ -162,12 +860,24 @@ void setup() {
     
     // Show "GM" during initialization
     uint16_t white = matrix->Color(255, 255, 255);
-    printTextCentered(32, 8, "GM", FONT_BUILTIN, white);
+    printTextCentered(MATRIX_WIDTH, MATRIX_HEIGHT / 2, "GM", FONT_BUILTIN, white);
     matrix->show();
     delay(1000);  // Show for 1 second
     
     // Create mutex for thread-safe access
     priceMutex = xSemaphoreCreateMutex();
+    resourceMutex = xSemaphoreCreateMutex();
+    recorderMutex = xSemaphoreCreateMutex();
+    sourceMutex = xSemaphoreCreateMutex();
+    
+    // Price task <-> fetch lane queues
+    laneResults = xQueueCreate(PRICE_LANES * 2, sizeof(PriceResult));
+    for (int lane = 0; lane < PRICE_LANES; lane++) {
+        laneRequests[lane] = xQueueCreate(1, sizeof(PriceRequest));
+    }
+    
+    // setup() runs in the Arduino loop task - remember it for stack monitoring
+    loopTaskHandle = xTaskGetCurrentTaskHandle();
     
     // Connect to WiFi
     connectToWiFi();
@@ -180,60 +890,107 @@ void setup() {
     
     // Create tasks for non-blocking HTTP requests
     if (WiFi.status() == WL_CONNECTED) {
-        Serial.println("Creating HTTP request tasks...");
-        addToConsoleBuffer("Creating HTTP request tasks...");
+        LOG_INFO("Creating HTTP request tasks...");
         
         // Create price fetching task on Core 0
         xTaskCreatePinnedToCore(
             fetchBTCPriceTask,    // Task function
             "PriceTask",          // Task name
-            8192,                 // Stack size
+            PRICE_TASK_STACK,     // Stack size
             NULL,                 // Parameters
             1,                    // Priority
             &priceTaskHandle,     // Task handle
             0                     // Core 0
         );
         
-        // Create OHLC fetching task on Core 0
+        // Fetch lanes the price task races sources on
+        for (int lane = 0; lane < PRICE_LANES; lane++) {
+            xTaskCreatePinnedToCore(
+                priceLaneTask,                 // Task function
+                lane == 0 ? "PriceLane0" : "PriceLane1",  // Task name
+                PRICE_LANE_STACK,              // Stack size
+                (void*)(intptr_t)lane,         // Parameters
+                1,                             // Priority
+                &priceLaneHandles[lane],       // Task handle
+                0                              // Core 0
+            );
+        }
+        
+        // Create OHLC fetching task on Core 0 (markets mode only needs it for backfill)
+        if (!MARKETS_FETCH || MARKETS_OHLC_BACKFILL) {
+            xTaskCreatePinnedToCore(
+                fetchOHLCDataTask,    // Task function
+                "OHLCTask",           // Task name
+                OHLC_TASK_STACK,      // Stack size
+                NULL,                 // Parameters
+                1,                    // Priority
+                &ohlcTaskHandle,      // Task handle
+                0                     // Core 0
+            );
+        }
+        
+        LOG_INFO("HTTP tasks created successfully!");
+    }
+    
+    // Heap/stack telemetry runs regardless of WiFi state
+    xTaskCreatePinnedToCore(
+        resourceMonitorTask,  // Task function
+        "MonitorTask",        // Task name
+        MONITOR_TASK_STACK,   // Stack size
+        NULL,                 // Parameters
+        1,                    // Priority
+        &monitorTaskHandle,   // Task handle
+        0                     // Core 0
+    );
+    
+    // LAN fan-out election and broadcasts follow WiFi state on their own
+    if (FANOUT_ENABLED) {
+        uint64_t mac = ESP.getEfuseMac();
+        fanout.begin((uint32_t)mac ^ (uint32_t)(mac >> 32), FANOUT_LEADER_TIMEOUT, FANOUT_STALE_AFTER);
         xTaskCreatePinnedToCore(
-            fetchOHLCDataTask,    // Task function
-            "OHLCTask",           // Task name
-            8192,                 // Stack size
+            fanoutTask,           // Task function
+            "FanoutTask",         // Task name
+            FANOUT_TASK_STACK,    // Stack size
             NULL,                 // Parameters
             1,                    // Priority
-            &ohlcTaskHandle,      // Task handle
+            &fanoutTaskHandle,    // Task handle
             0                     // Core 0
         );
-        
-        Serial.println("HTTP tasks created successfully!");
-        addToConsoleBuffer("HTTP tasks created successfully!");
     }
     
-    Serial.println("Setup complete!");
-    addToConsoleBuffer("Setup complete!");
+    LOG_INFO("Setup complete!");
 }
 
 void loop() {
-    // Handle OTA updates
-    ArduinoOTA.handle();
+    // Handle OTA updates. espota re-sends its invitation, so polling a few times a
+    // second is enough and spares the render loop a heap allocation every frame.
+    static unsigned long lastOtaPoll = 0;
+    if (otaInProgress || millis() - lastOtaPoll >= OTA_POLL_INTERVAL) {
+        AllocScope otaPoll;  // WiFiUDP::parsePacket allocates its receive buffer
+        ArduinoOTA.handle();
+        lastOtaPoll = millis();
+    }
     
-    // Handle web server requests
-    server.handleClient();
+    // Pull OTA owns the LEDs for its progress bar
+    if (otaInProgress) {
+        delay(50);
+        return;
+    }
     
     // Don't clear entire screen - causes flicker
     
     // Check WiFi connection with enhanced monitoring
     if (WiFi.status() != WL_CONNECTED) {
+        AllocScope reconnecting;  // Scans and reconnects aren't steady state
         if (wifiConnected) {
             // Just lost connection - log the event
-            Serial.printf("WiFi connection lost! Previous RSSI: %ddBm\n", WiFi.RSSI());
-            addToConsoleBuffer("WiFi connection lost - attempting reconnect");
+            LOG_WARN("WiFi connection lost (previous RSSI %ddBm) - attempting reconnect", WiFi.RSSI());
             wifiConnected = false;
         }
         
         // Show scrolling "Offline" text
         uint16_t red = matrix->Color(255, 0, 0);
-        updateScrollingText(8, "Offline", offlineScroll, 32, FONT_BUILTIN, red);
+        updateScrollingText(MATRIX_HEIGHT / 2, "Offline", offlineScroll, MATRIX_WIDTH, FONT_BUILTIN, red);
         
         // Smarter reconnection with escalating intervals
         unsigned long timeSinceLastAttempt = millis() - lastReconnectAttempt;
@@ -249,11 +1006,10 @@ void loop() {
         
         if (timeSinceLastAttempt > reconnectInterval) {
             reconnectAttempts++;
-            Serial.printf("WiFi offline for %lu seconds, reconnect attempt #%d\n", 
-                         timeSinceLastAttempt / 1000, reconnectAttempts);
+            LOG_INFO("WiFi offline for %lu seconds, reconnect attempt #%d", timeSinceLastAttempt / 1000, reconnectAttempts);
             
             // Reset offline scroll for next display cycle
-            offlineScroll.reset(32);
+            offlineScroll.reset(MATRIX_WIDTH);
             
             // Check if we can see our network before attempting connection
             WiFi.scanNetworks(true);  // Async scan
@@ -278,32 +1034,60 @@ void loop() {
         // Clear display and show brief connection success
         fill_solid(leds, NUM_LEDS, CRGB::Black);
         uint16_t green = matrix->Color(0, 255, 0);
-        printTextCentered(32, 8, "Connected", FONT_TOMTHUMB, green);
+        printTextCentered(MATRIX_WIDTH, MATRIX_HEIGHT / 2, "Connected", STATUS_FONT, green);
         matrix->show();
         delay(1000);  // Show success message briefly
         fill_solid(leds, NUM_LEDS, CRGB::Black);
         matrix->show();
     }
     
-    // Display BTC ticker if we have price data
-    if (currentBTCPrice > 0) {
-        
-        // Clear price area to prevent ghosting
-        matrix->fillRect(0, 0, 32, 8, 0);  // Clear top price area
-        
-        // Display BTC price centered at top (white, whole number)
-        char priceStr[16];
-        sprintf(priceStr, "%.0f", currentBTCPrice);  // Whole number, no decimals
-        uint16_t white = matrix->Color(255, 255, 255);
-        printTextCentered(32, 7, priceStr, FONT_TOMTHUMB, white);
-        
-        // Display scrolling multi-timeframe changes at bottom (each interval color-coded)
-        updateMultiColorScrollingText(14, changeScroll, FONT_TOMTHUMB);
+    // Pick up a new snapshot if a fetch task signalled one (retried next frame if the mutex is busy)
+    static bool snapshotStale = false;
+    static bool measureTick = false;
+    static unsigned long renderTickReceivedAt = 0;
+    snapshotStale |= framePacer.updateSignalled || ulTaskNotifyTake(pdTRUE, 0) > 0;
+    framePacer.updateSignalled = false;
+    
+    if (snapshotStale && xSemaphoreTake(priceMutex, pdMS_TO_TICKS(5)) == pdTRUE) {
+        renderSnapshot.price = currentBTCPrice;
+        renderSnapshot.change1h = btc1hChange;
+        renderSnapshot.change1d = btc1dChange;
+        renderSnapshot.change24h = btc24hChange;
+        measureTick = tickPending;
+        renderTickReceivedAt = tickReceivedAt;
+        tickPending = false;
+        xSemaphoreGive(priceMutex);
+        snapshotStale = false;
     }
+    
+    // Replay requested over HTTP - runs here so it owns the display
+    if (replayRequested) {
+        replayRequested = false;
+        runReplay();
+    }
+    
+    // Display BTC ticker if we have price data
+    unsigned long now = millis();
+    renderTicker(changeScroll, now);
 
     matrix->show();
+    
+    if (recorder.framesEnabled) {
+        recordFrame(now);
+    }
+    
+    // New digits are on the LEDs now - record how long the tick took to get here
+    if (measureTick) {
+        recordTickLatency(micros() - renderTickReceivedAt);
+        measureTick = false;
+    }
+    
+    framePacer.wait(renderSnapshot.price > 0);
 }
 
+// The scan listing and the per-attempt progress trace go straight to Serial: they are
+// built up piecemeal and only matter to someone watching the port. Outcomes go
+// through LOG_* like everything else.
 void connectToWiFi() {
     Serial.print("Connecting to WiFi SSID: ");
     Serial.println(WIFI_SSID);
@@ -347,14 +1131,11 @@ void connectToWiFi() {
     }
     
     if (!targetFound) {
-        Serial.printf("ERROR: Target SSID '%s' not found in scan!\n", WIFI_SSID);
-        addToConsoleBuffer("ERROR: Target SSID not found in scan");
+        LOG_ERROR("Target SSID '%s' not found in scan", WIFI_SSID);
         return;
     }
     
-    Serial.printf("Connecting to strongest '%s' signal: %ddBm (channel %d)\n", 
-                  WIFI_SSID, bestRSSI, bestChannel);
-    addToConsoleBuffer("Connecting to strongest signal: " + String(bestRSSI) + "dBm");
+    LOG_INFO("Connecting to strongest '%s' signal: %ddBm (channel %d)", WIFI_SSID, bestRSSI, bestChannel);
     
     // Reset scroll state for "Connecting..." animation (start from left visible)
     connectingScroll.reset(0);  // Start from left edge, visible immediately
@@ -390,7 +1171,7 @@ void connectToWiFi() {
             uint16_t yellow = matrix->Color(255, 255, 0);
             char connectMsg[32];
             sprintf(connectMsg, "Connecting %d/%d...", attempt, WIFI_MAX_ATTEMPTS);
-            updateScrollingText(5, connectMsg, connectingScroll, 32, FONT_BUILTIN, yellow);
+            updateScrollingText(MATRIX_HEIGHT / 2 - 3, connectMsg, connectingScroll, MATRIX_WIDTH, FONT_BUILTIN, yellow);
             
             delay(200);
             Serial.print(".");
@@ -425,13 +1206,9 @@ void connectToWiFi() {
         // Check final result
         if (WiFi.status() == WL_CONNECTED) {
             wifiConnected = true;
-            Serial.printf("\n✓ WiFi connected successfully on attempt %d!\n", attempt);
-            Serial.printf("IP address: %s\n", WiFi.localIP().toString().c_str());
-            Serial.printf("Signal strength: %ddBm\n", WiFi.RSSI());
-            Serial.printf("Channel: %d\n", WiFi.channel());
-            
-            addToConsoleBuffer("WiFi connected! IP: " + WiFi.localIP().toString() + 
-                              " RSSI: " + String(WiFi.RSSI()) + "dBm");
+            Serial.println();
+            LOG_INFO("WiFi connected on attempt %d! IP: %s RSSI: %ddBm channel %d",
+                     attempt, WiFi.localIP().toString().c_str(), WiFi.RSSI(), WiFi.channel());
             
             // Flash green to indicate WiFi connection
             fill_solid(leds, NUM_LEDS, CRGB::Green);
@@ -442,15 +1219,15 @@ void connectToWiFi() {
             return;
         } else {
             wl_status_t finalStatus = WiFi.status();
-            Serial.printf("\n✗ Attempt %d failed. Final status: %d\n", attempt, finalStatus);
+            Serial.println();
             
             // Handle specific error cases
             if (finalStatus == WL_CONNECT_FAILED) {
-                Serial.println("Authentication likely failed - check password");
-                addToConsoleBuffer("Auth failed - check password (attempt " + String(attempt) + ")");
+                LOG_WARN("WiFi attempt %d failed: authentication likely failed - check password", attempt);
             } else if (finalStatus == WL_NO_SSID_AVAIL) {
-                Serial.println("SSID not available - signal may be too weak");
-                addToConsoleBuffer("SSID unavailable (attempt " + String(attempt) + ")");
+                LOG_WARN("WiFi attempt %d failed: SSID not available - signal may be too weak", attempt);
+            } else {
+                LOG_WARN("WiFi attempt %d failed, final status: %d", attempt, finalStatus);
             }
             
             // Wait before next attempt (exponential backoff)
@@ -463,8 +1240,7 @@ void connectToWiFi() {
     }
     
     // All attempts failed
-    Serial.println("\n✗ All connection attempts failed!");
-    addToConsoleBuffer("All WiFi connection attempts failed");
+    LOG_ERROR("All WiFi connection attempts failed");
     
     // Flash red to indicate WiFi failure
     fill_solid(leds, NUM_LEDS, CRGB::Red);
@@ -477,38 +1253,38 @@ void connectToWiFi() {
 void setupOTA() {
     // Set hostname for mDNS
     if (!MDNS.begin(DEVICE_HOSTNAME)) {
-        Serial.println("Error setting up mDNS responder!");
+        LOG_ERROR("Error setting up mDNS responder!");
         return;
     }
-    Serial.println("mDNS responder started");
+    LOG_INFO("mDNS responder started");
     
     // Configure OTA
     ArduinoOTA.setHostname(DEVICE_HOSTNAME);
     
     // Pre-flight checks for OTA readiness
-    Serial.println("=== OTA PRE-FLIGHT CHECKS ===");
-    Serial.printf("Total heap: %d bytes\n", ESP.getHeapSize());
-    Serial.printf("Free heap: %d bytes\n", ESP.getFreeHeap());
-    Serial.printf("Min free heap: %d bytes\n", ESP.getMinFreeHeap());
-    Serial.printf("Max alloc heap: %d bytes\n", ESP.getMaxAllocHeap());
-    Serial.printf("Flash size: %d bytes\n", ESP.getFlashChipSize());
-    Serial.printf("Free sketch space: %d bytes\n", ESP.getFreeSketchSpace());
+    LOG_INFO("OTA pre-flight: heap %u bytes, %u free (min %u, max alloc %u)",
+             ESP.getHeapSize(), ESP.getFreeHeap(), ESP.getMinFreeHeap(), ESP.getMaxAllocHeap());
+    LOG_INFO("OTA pre-flight: flash %u bytes, %u free sketch space",
+             ESP.getFlashChipSize(), ESP.getFreeSketchSpace());
     
     // Verify we have adequate space for OTA
     if (ESP.getFreeSketchSpace() < 1000000) {
-        Serial.println("WARNING: Insufficient flash space for OTA!");
-        addToConsoleBuffer("WARNING: Insufficient flash space for OTA!");
+        LOG_WARN("Insufficient flash space for OTA!");
     } else {
-        Serial.println("Flash space check: PASSED");
-        addToConsoleBuffer("Flash space check: PASSED");
+        LOG_INFO("Flash space check: PASSED");
     }
     
-    // OTA event handlers with LED feedback and HTTP task management
+    // OTA event handlers with LED feedback and HTTP task management. These, the pull
+    // task and suspend/resumeHttpTasks() write to Serial and the console directly
+    // rather than through LOG_*: the update runs with the other tasks suspended and
+    // ends in a restart, and queued lines would not be drained before it.
     ArduinoOTA.onStart([]() {
-        String type = (ArduinoOTA.getCommand() == U_FLASH) ? "sketch" : "filesystem";
+        const char* type = (ArduinoOTA.getCommand() == U_FLASH) ? "sketch" : "filesystem";
+        char line[48];
+        snprintf(line, sizeof(line), "OTA UPDATE STARTING - Type: %s", type);
         Serial.println("=== OTA UPDATE STARTING ===");
-        Serial.println("Updating: " + type);
-        addToConsoleBuffer("OTA UPDATE STARTING - Type: " + type);
+        Serial.printf("Updating: %s\n", type);
+        addToConsoleBuffer(line);
         
         // Print memory and flash information for debugging
         Serial.printf("Free heap: %d bytes\n", ESP.getFreeHeap());
@@ -537,13 +1313,12 @@ void setupOTA() {
         // Note: Don't fully disable watchdog as it can cause other issues
         esp_task_wdt_reset();  // Reset watchdog before long operation
         
-        // Turn off ALL LEDs to reduce power consumption during flash operations
-        fill_solid(leds, NUM_LEDS, CRGB::Black);
-        FastLED.setBrightness(0);  // Minimize power draw
-        FastLED.show();
+        // Dim everything except a thin progress bar to keep power draw low during flash operations
+        FastLED.setBrightness(OTA_BRIGHTNESS);
+        showOtaProgress(0, CRGB(96, 0, 96));
         
-        Serial.println("Watchdog disabled, LEDs off, tasks suspended");
-        addToConsoleBuffer("OTA environment: watchdog disabled, LEDs off, tasks suspended");
+        Serial.println("Watchdog disabled, LEDs dimmed, tasks suspended");
+        addToConsoleBuffer("OTA environment: watchdog disabled, LEDs dimmed, tasks suspended");
         
         Serial.println("OTA environment prepared successfully");
         addToConsoleBuffer("OTA environment prepared successfully");
@@ -586,34 +1361,29 @@ void setupOTA() {
             }
         }
         
-        // LEDs disabled during OTA to reduce power consumption
-        // No LED updates to avoid interfering with flash operations
+        // Dim progress bar, only redrawn when the percentage changes
+        showOtaProgress(percent, CRGB(96, 0, 96));
     });
     
     ArduinoOTA.onError([](ota_error_t error) {
         Serial.printf("=== OTA ERROR [%u] ===\n", error);
-        String errorMsg = "OTA ERROR: ";
+        const char* reason = "Unknown Error";
         
         if (error == OTA_AUTH_ERROR) {
-            Serial.println("Authentication Failed");
-            errorMsg += "Authentication Failed";
+            reason = "Authentication Failed";
         } else if (error == OTA_BEGIN_ERROR) {
-            Serial.println("Begin Failed");
-            errorMsg += "Begin Failed";
+            reason = "Begin Failed";
         } else if (error == OTA_CONNECT_ERROR) {
-            Serial.println("Connect Failed");
-            errorMsg += "Connect Failed";
+            reason = "Connect Failed";
         } else if (error == OTA_RECEIVE_ERROR) {
-            Serial.println("Receive Failed");
-            errorMsg += "Receive Failed";
+            reason = "Receive Failed";
         } else if (error == OTA_END_ERROR) {
-            Serial.println("End Failed");
-            errorMsg += "End Failed";
-        } else {
-            Serial.println("Unknown Error");
-            errorMsg += "Unknown Error";
+            reason = "End Failed";
         }
         
+        char errorMsg[48];
+        snprintf(errorMsg, sizeof(errorMsg), "OTA ERROR: %s", reason);
+        Serial.println(reason);
         addToConsoleBuffer(errorMsg);
         
         // Restore LED brightness and show error
@@ -630,273 +1400,1599 @@ void setupOTA() {
     });
     
     ArduinoOTA.begin();
-    Serial.println("OTA Ready");
-    Serial.print("IP address: ");
-    Serial.println(WiFi.localIP());
+    LOG_INFO("OTA Ready at %s", WiFi.localIP().toString().c_str());
 }
 
-void addToConsoleBuffer(const String& message) {
-    // Add timestamp
-    String timestampedMessage = "[" + String(millis()) + "] " + message + "\n";
-    consoleBuffer += timestampedMessage;
-    
-    // Keep buffer size manageable
-    if (consoleBuffer.length() > MAX_CONSOLE_BUFFER) {
-        consoleBuffer = consoleBuffer.substring(consoleBuffer.length() - MAX_CONSOLE_BUFFER);
+// Minimal OTA progress bar: two dim rows across the middle of the matrix.
+// Only redrawn when the percentage changes, so it costs at most 100 show() calls.
+void showOtaProgress(unsigned int percent, CRGB color) {
+    static int lastPercent = -1;
+    static CRGB lastColor;
+    if ((int)percent == lastPercent && color == lastColor) {
+        return;
     }
-}
-
-void setupWebServer() {
-    // Console monitoring page
-    server.on("/", []() {
-        String html = "<!DOCTYPE html><html><head><title>ESP32 BTC Ticker Console</title>";
-        html += "<meta http-equiv='refresh' content='2'>";
-        html += "<style>body{font-family:monospace;background:#000;color:#0f0;padding:20px;} ";
-        html += "pre{white-space:pre-wrap;word-wrap:break-word;}</style></head>";
-        html += "<body><h1>ESP32 BTC Ticker Console</h1>";
-        html += "<p>Auto-refresh every 2 seconds | <a href='/clear'>Clear Buffer</a></p>";
-        html += "<pre>" + consoleBuffer + "</pre>";
-        html += "</body></html>";
-        server.send(200, "text/html", html);
-    });
-    
-    // API endpoint for just the console data
-    server.on("/console", []() {
-        server.send(200, "text/plain", consoleBuffer);
-    });
-    
-    // Clear console buffer
-    server.on("/clear", []() {
-        consoleBuffer = "";
-        addToConsoleBuffer("Console buffer cleared");
-        server.sendHeader("Location", "/");
-        server.send(302, "text/plain", "");
-    });
+    lastPercent = percent;
+    lastColor = color;
     
-    server.begin();
-    Serial.println("Web server started on http://" + String(DEVICE_HOSTNAME) + ".local");
-    addToConsoleBuffer("Web server started on http://" + String(DEVICE_HOSTNAME) + ".local");
+    fill_solid(leds, NUM_LEDS, CRGB::Black);
+    int16_t filled = (int16_t)((long)MATRIX_WIDTH * min(percent, 100U) / 100);
+    for (int16_t x = 0; x < MATRIX_WIDTH; x++) {
+        CRGB pixel = x < filled ? color : CRGB(8, 0, 8);  // Faint track for the remainder
+        leds[ledIndex[MATRIX_HEIGHT / 2 - 1][x]] = pixel;
+        leds[ledIndex[MATRIX_HEIGHT / 2][x]] = pixel;
+    }
+    FastLED.show();
 }
 
-// Task function for fetching BTC price (runs on separate core)
-void fetchBTCPriceTask(void *pvParameters) {
-    HTTPClient http;
-    WiFiClientSecure client;
-    client.setInsecure(); // Skip certificate verification for faster performance
-    
-    while (true) {
-        // Skip HTTP requests during OTA to avoid conflicts
-        if (wifiConnected && !priceRequestInProgress && !otaInProgress) {
-            priceRequestInProgress = true;
-            
-            http.begin(client, BTC_API_URL);
-            http.addHeader("x-cg-pro-api-key", COINGECKO_API_KEY);
-            
-            int httpCode = http.GET();
-            
-            if (httpCode == HTTP_CODE_OK) {
-                String payload = http.getString();
-                
-                // Parse JSON response
-                DynamicJsonDocument doc(1024);
-                if (deserializeJson(doc, payload) == DeserializationError::Ok) {
-                    if (doc["bitcoin"]["usd"] && doc["bitcoin"]["usd_24h_change"]) {
-                        // Thread-safe update of shared variables
-                        if (xSemaphoreTake(priceMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-                            currentBTCPrice = doc["bitcoin"]["usd"];
-                            btc24hChange = doc["bitcoin"]["usd_24h_change"];
-                            
-                            // Round to nearest cent
-                            currentBTCPrice = round(currentBTCPrice * 100.0) / 100.0;
-                            btc24hChange = round(btc24hChange * 100.0) / 100.0;
-                            
-                            Serial.printf("[TASK] BTC price: $%.2f USD, 24h: %+.2f%%\n", currentBTCPrice, btc24hChange);
-                            addToConsoleBuffer("BTC price: $" + String(currentBTCPrice, 2) + " USD, 24h: " + String(btc24hChange, 2) + "%");
-                            xSemaphoreGive(priceMutex);
-                        }
+// Streaming gzip header parser (RFC 1952); returns bytes consumed from data. Sets
+// otaPull.stage to OTA_STAGE_INFLATE once the deflate stream begins.
+size_t parseGzipHeader(const uint8_t* data, size_t len) {
+    size_t i = 0;
+    while (i < len && otaPull.stage != OTA_STAGE_INFLATE) {
+        uint8_t byte = data[i++];
+        switch (otaPull.stage) {
+            case OTA_STAGE_GZIP_FIXED:
+                // ID1 ID2 CM FLG MTIME(4) XFL OS; 1f 8b 08 = gzip with deflate
+                if ((otaPull.headerPos == 1 && byte != 0x8b) || (otaPull.headerPos == 2 && byte != 0x08)) {
+                    Serial.println("OTA: image starts with 0x1f but is not gzip/deflate");
+                    otaPull.failed = true;
+                    return i;
+                }
+                if (otaPull.headerPos == 3) {
+                    otaPull.gzipFlags = byte;
+                }
+                if (++otaPull.headerPos == 10) {
+                    otaPull.headerPos = 0;
+                    otaPull.stage = OTA_STAGE_GZIP_EXTRA;
+                }
+                break;
+            case OTA_STAGE_GZIP_EXTRA:
+                if (!(otaPull.gzipFlags & 0x04)) {
+                    otaPull.stage = OTA_STAGE_GZIP_NAME;
+                    i--;  // Not consumed
+                } else if (otaPull.headerPos < 2) {
+                    otaPull.extraRemaining |= (uint16_t)byte << (8 * otaPull.headerPos++);
+                    if (otaPull.headerPos == 2 && otaPull.extraRemaining == 0) {
+                        otaPull.stage = OTA_STAGE_GZIP_NAME;
                     }
+                } else if (--otaPull.extraRemaining == 0) {
+                    otaPull.stage = OTA_STAGE_GZIP_NAME;
                 }
-            } else {
-                Serial.printf("[TASK] HTTP GET failed, error: %d\n", httpCode);
+                break;
+            case OTA_STAGE_GZIP_NAME:
+                if (!(otaPull.gzipFlags & 0x08)) {
+                    otaPull.stage = OTA_STAGE_GZIP_COMMENT;
+                    i--;
+                } else if (byte == 0) {
+                    otaPull.stage = OTA_STAGE_GZIP_COMMENT;
+                }
+                break;
+            case OTA_STAGE_GZIP_COMMENT:
+                if (!(otaPull.gzipFlags & 0x10)) {
+                    otaPull.headerPos = 0;
+                    otaPull.stage = (otaPull.gzipFlags & 0x02) ? OTA_STAGE_GZIP_HCRC : OTA_STAGE_INFLATE;
+                    i--;
+                } else if (byte == 0) {
+                    otaPull.headerPos = 0;
+                    otaPull.stage = (otaPull.gzipFlags & 0x02) ? OTA_STAGE_GZIP_HCRC : OTA_STAGE_INFLATE;
+                }
+                break;
+            case OTA_STAGE_GZIP_HCRC:
+                if (++otaPull.headerPos == 2) {
+                    otaPull.stage = OTA_STAGE_INFLATE;
+                }
+                break;
+            default:
+                break;
+        }
+    }
+    return i;
+}
+
+// Hash and flash one block of decompressed firmware
+bool writeFirmwareBlock(uint8_t* data, size_t len) {
+    mbedtls_sha256_update(&otaPull.sha, data, len);
+    otaPull.imageBytes += len;
+    return Update.write(data, len) == len;
+}
+
+// Feed downloaded bytes through gzip decoding (if needed) into the update partition
+bool consumeFirmwareBytes(uint8_t* data, size_t len) {
+    if (otaPull.stage == OTA_STAGE_DETECT) {
+        // 1f 8b 08 is the gzip magic (checked byte by byte by parseGzipHeader, as a read can
+        // split it). Firmware images start with 0xe9, so anything else is written raw.
+        otaPull.stage = (data[0] == 0x1f) ? OTA_STAGE_GZIP_FIXED : OTA_STAGE_RAW;
+        otaPull.compressed = otaPull.stage == OTA_STAGE_GZIP_FIXED;
+    }
+    
+    if (otaPull.stage == OTA_STAGE_RAW) {
+        return writeFirmwareBlock(data, len);
+    }
+    if (otaPull.stage == OTA_STAGE_DONE) {
+        return true;  // gzip trailer (CRC32 + size) - integrity comes from SHA-256
+    }
+    
+    size_t consumed = 0;
+    if (otaPull.stage != OTA_STAGE_INFLATE) {
+        consumed = parseGzipHeader(data, len);
+        if (otaPull.failed) {
+            return false;
+        }
+    }
+    
+    while (consumed < len || otaPull.inflateStatus == TINFL_STATUS_HAS_MORE_OUTPUT) {
+        size_t inBytes = len - consumed;
+        size_t outBytes = TINFL_LZ_DICT_SIZE - otaPull.dictOffset;
+        otaPull.inflateStatus = tinfl_decompress(otaPull.inflator, data + consumed, &inBytes,
+                                                 otaPull.dict, otaPull.dict + otaPull.dictOffset, &outBytes,
+                                                 TINFL_FLAG_HAS_MORE_INPUT);
+        consumed += inBytes;
+        
+        if (outBytes > 0) {
+            if (!writeFirmwareBlock(otaPull.dict + otaPull.dictOffset, outBytes)) {
+                return false;
             }
-            
+            otaPull.dictOffset = (otaPull.dictOffset + outBytes) & (TINFL_LZ_DICT_SIZE - 1);
+        }
+        
+        if (otaPull.inflateStatus == TINFL_STATUS_DONE) {
+            otaPull.stage = OTA_STAGE_DONE;
+            return true;
+        }
+        if (otaPull.inflateStatus < 0) {
+            Serial.printf("OTA: gzip stream corrupt (status %d)\n", otaPull.inflateStatus);
+            return false;
+        }
+        if (otaPull.inflateStatus == TINFL_STATUS_NEEDS_MORE_INPUT && consumed == len) {
+            break;
+        }
+    }
+    return true;
+}
+
+// One HTTP request for the rest of the file. Returns true when the whole file has
+// been received; on a dropped connection the next call resumes with a Range header.
+bool downloadFirmwareRange(HTTPClient& http, WiFiClient& client, uint8_t* buffer) {
+    http.begin(client, otaPull.url);
+    if (otaPull.receivedBytes > 0) {
+        http.addHeader("Range", "bytes=" + String(otaPull.receivedBytes) + "-");
+    }
+    const char* rangeHeaders[] = {"Content-Range"};
+    http.collectHeaders(rangeHeaders, 1);
+    
+    int httpCode = http.GET();
+    if (httpCode == HTTP_CODE_PARTIAL_CONTENT) {
+        // The part must start exactly where we stopped, in the same file - anything else
+        // would splice the wrong bytes into the decoder, so start over
+        String contentRange = http.header("Content-Range");
+        size_t first;
+        long total;
+        if (!parseContentRange(contentRange.c_str(), first, total) || first != otaPull.receivedBytes ||
+            (total >= 0 && total != otaPull.totalBytes)) {
+            Serial.printf("OTA: Content-Range '%s' doesn't resume at %u bytes, restarting download\n",
+                          contentRange.c_str(), otaPull.receivedBytes);
+            otaPull.failed = true;
             http.end();
+            return false;
+        }
+    }
+    if (httpCode == HTTP_CODE_OK && otaPull.receivedBytes > 0) {
+        // Server ignored the Range header - decoder state can't be rewound, so start over
+        Serial.println("OTA: server does not support ranges, restarting download");
+        otaPull.failed = true;
+        http.end();
+        return false;
+    }
+    if (httpCode != HTTP_CODE_OK && httpCode != HTTP_CODE_PARTIAL_CONTENT) {
+        Serial.printf("OTA: HTTP GET failed, error: %d\n", httpCode);
+        http.end();
+        return false;
+    }
+    if (httpCode == HTTP_CODE_OK) {
+        otaPull.totalBytes = http.getSize();
+    }
+    
+    WiFiClient* stream = http.getStreamPtr();
+    unsigned long lastData = millis();
+    while (http.connected() && (otaPull.totalBytes <= 0 || otaPull.receivedBytes < (size_t)otaPull.totalBytes)) {
+        size_t available = stream->available();
+        if (available == 0) {
+            if (millis() - lastData > OTA_STALL_TIMEOUT) {
+                Serial.printf("OTA: stalled at %u bytes, will resume\n", otaPull.receivedBytes);
+                break;
+            }
+            delay(5);
+            continue;
+        }
+        
+        size_t bytesRead = stream->readBytes(buffer, min(available, (size_t)OTA_CHUNK_SIZE));
+        lastData = millis();
+        otaPull.receivedBytes += bytesRead;
+        
+        if (!consumeFirmwareBytes(buffer, bytesRead)) {
+            otaPull.failed = true;
+            break;
+        }
+        
+        if (otaPull.totalBytes > 0) {
+            showOtaProgress(100UL * otaPull.receivedBytes / otaPull.totalBytes, CRGB(96, 0, 96));
+        }
+    }
+    
+    http.end();
+    return !otaPull.failed && otaPull.totalBytes > 0 && otaPull.receivedBytes >= (size_t)otaPull.totalBytes;
+}
+
+// Reset decoder, hash and flash state for a fresh download
+bool beginFirmwareImage() {
+    otaPull.stage = OTA_STAGE_DETECT;
+    otaPull.headerPos = 0;
+    otaPull.extraRemaining = 0;
+    otaPull.dictOffset = 0;
+    otaPull.inflateStatus = TINFL_STATUS_NEEDS_MORE_INPUT;
+    otaPull.receivedBytes = 0;
+    otaPull.imageBytes = 0;
+    otaPull.totalBytes = -1;
+    otaPull.failed = false;
+    tinfl_init(otaPull.inflator);
+    mbedtls_sha256_init(&otaPull.sha);
+    mbedtls_sha256_starts(&otaPull.sha, 0);
+    return Update.begin(UPDATE_SIZE_UNKNOWN, U_FLASH);
+}
+
+// Download, decompress, verify and install firmware from otaPull.url, then reboot
+void otaPullTask(void *pvParameters) {
+    unsigned long startTime = millis();
+    size_t wastedBytes = 0;   // Bytes received before a restart-from-scratch
+    size_t resumedBytes = 0;  // Bytes a non-resumable transfer would have re-sent
+    bool success = false;
+    
+    otaInProgress = true;
+    suspendHttpTasks();
+    FastLED.setBrightness(OTA_BRIGHTNESS);
+    showOtaProgress(0, CRGB(96, 0, 96));
+    
+    Serial.printf("=== OTA PULL STARTING: %s ===\n", otaPull.url);
+    addToConsoleBuffer("OTA PULL STARTING: " + String(otaPull.url));
+    
+    // Decoder state lives on the heap only for the duration of the update
+    otaPull.dict = (uint8_t*)malloc(TINFL_LZ_DICT_SIZE);
+    otaPull.inflator = (tinfl_decompressor*)malloc(sizeof(tinfl_decompressor));
+    uint8_t* buffer = (uint8_t*)malloc(OTA_CHUNK_SIZE);
+    
+    if (otaPull.dict == NULL || otaPull.inflator == NULL || buffer == NULL || !beginFirmwareImage()) {
+        Serial.println("OTA: not enough memory or flash space to begin");
+        addToConsoleBuffer("OTA ERROR: Begin Failed");
+    } else {
+        HTTPClient http;
+        WiFiClient client;
+        
+        for (int attempt = 1; attempt <= OTA_MAX_ATTEMPTS && !success; attempt++) {
+            if (downloadFirmwareRange(http, client, buffer)) {
+                success = true;
+                break;
+            }
+            if (otaPull.failed) {
+                // Corrupt stream or no range support - throw away what we have and restart
+                wastedBytes += otaPull.receivedBytes;
+                Update.abort();
+                mbedtls_sha256_free(&otaPull.sha);
+                if (!beginFirmwareImage()) {
+                    break;
+                }
+            } else {
+                resumedBytes += otaPull.receivedBytes;
+            }
+            Serial.printf("OTA: attempt %d/%d interrupted at %u bytes\n", attempt, OTA_MAX_ATTEMPTS, otaPull.receivedBytes);
+            addToConsoleBuffer("OTA attempt " + String(attempt) + " interrupted at " + String(otaPull.receivedBytes) + " bytes");
+            delay(1000 * attempt);
+        }
+        
+        if (success && otaPull.compressed && otaPull.stage != OTA_STAGE_DONE) {
+            Serial.println("OTA: gzip stream ended early");
+            success = false;
+        }
+        
+        // Verify the decompressed image before the boot partition is switched
+        if (success) {
+            uint8_t digest[32];
+            char digestHex[65];
+            mbedtls_sha256_finish(&otaPull.sha, digest);
+            for (int i = 0; i < 32; i++) {
+                sprintf(digestHex + i * 2, "%02x", digest[i]);
+            }
+            if (strcasecmp(digestHex, otaPull.expectedSha256) != 0) {
+                Serial.printf("OTA: SHA-256 mismatch, got %s\n", digestHex);
+                addToConsoleBuffer("OTA ERROR: SHA-256 mismatch");
+                success = false;
+            }
+        }
+        mbedtls_sha256_free(&otaPull.sha);
+        
+        if (success && !Update.end(true)) {
+            Serial.printf("OTA: finalize failed: %s\n", Update.errorString());
+            success = false;
+        }
+        if (!success) {
+            Update.abort();
+        }
+    }
+    
+    free(buffer);
+    free(otaPull.inflator);
+    free(otaPull.dict);
+    otaPull.inflator = NULL;
+    otaPull.dict = NULL;
+    
+    if (success) {
+        // Throughput-bound transfer: time saved scales with the compression ratio
+        unsigned long elapsed = millis() - startTime;
+        float ratio = otaPull.receivedBytes > 0 ? (float)otaPull.imageBytes / otaPull.receivedBytes : 1.0f;
+        unsigned long savedMs = (unsigned long)(elapsed * (ratio - 1.0f));
+        Serial.printf("=== OTA PULL COMPLETED: %u bytes -> %u byte image in %lu ms ===\n",
+                      otaPull.receivedBytes, otaPull.imageBytes, elapsed);
+        Serial.printf("Compression saved ~%lu ms of transfer; resume avoided re-sending %u bytes (%u bytes wasted)\n",
+                      savedMs, resumedBytes, wastedBytes);
+        addToConsoleBuffer("OTA PULL COMPLETED in " + String(elapsed) + "ms, ~" + String(savedMs) +
+                           "ms saved by compression, " + String(resumedBytes) + " bytes saved by resume");
+        
+        showOtaProgress(100, CRGB::Green);
+        delay(1000);
+        ESP.restart();
+    }
+    
+    Serial.println("=== OTA PULL FAILED ===");
+    addToConsoleBuffer("OTA PULL FAILED");
+    FastLED.setBrightness(BRIGHTNESS);
+    fill_solid(leds, NUM_LEDS, CRGB::Red);
+    FastLED.show();
+    delay(1000);
+    
+    otaInProgress = false;
+    resumeHttpTasks();
+    otaPullTaskHandle = NULL;
+    vTaskDelete(NULL);
+}
+
+// Start a pull OTA in the background. Returns false if one is already running.
+bool startOtaPull(const String& url, const String& sha256) {
+    if (otaInProgress || otaPullTaskHandle != NULL) {
+        return false;
+    }
+    strlcpy(otaPull.url, url.c_str(), sizeof(otaPull.url));
+    strlcpy(otaPull.expectedSha256, sha256.c_str(), sizeof(otaPull.expectedSha256));
+    
+    xTaskCreatePinnedToCore(
+        otaPullTask,          // Task function
+        "OTAPullTask",        // Task name
+        OTA_PULL_TASK_STACK,  // Stack size
+        NULL,                 // Parameters
+        1,                    // Priority
+        &otaPullTaskHandle,   // Task handle
+        0                     // Core 0
+    );
+    return otaPullTaskHandle != NULL;
+}
+
+void addToConsoleBuffer(const String& message) {
+    appendToConsole(millis(), message.c_str());
+}
+
+void addToConsoleBuffer(const char* message) {
+    appendToConsole(millis(), message);
+}
+
+// Copy text into the console ring, overwriting the oldest text once it is full.
+// Caller holds consoleMutex.
+void consoleWrite(const char* text, size_t len) {
+    for (size_t i = 0; i < len; i++) {
+        consoleRing[consoleHead] = text[i];
+        consoleHead = (consoleHead + 1) % MAX_CONSOLE_BUFFER;
+    }
+    consoleUsed = min(consoleUsed + len, (size_t)MAX_CONSOLE_BUFFER);
+    consoleWritten += len;
+}
+
+// Append one timestamped line to the web console buffer
+void appendToConsole(unsigned long timestamp, const char* message) {
+    char stamp[16];
+    int stampLen = snprintf(stamp, sizeof(stamp), "[%lu] ", timestamp);
+    
+    // Web handlers read the buffer from the async server task
+    bool locked = consoleMutex != NULL && xSemaphoreTake(consoleMutex, pdMS_TO_TICKS(50)) == pdTRUE;
+    consoleWrite(stamp, stampLen);
+    consoleWrite(message, strlen(message));
+    consoleWrite("\n", 1);
+    if (locked) {
+        xSemaphoreGive(consoleMutex);
+    }
+}
+
+// Chunked-response filler: streams prefix, the console ring as it was when the response
+// started, then suffix, without building the whole body in RAM. Text that gets
+// overwritten before it is sent is replaced by a marker rather than torn.
+size_t fillConsoleChunk(ConsoleCursor& cursor, uint8_t* buffer, size_t maxLen, size_t index,
+                        const char* prefix, const char* suffix) {
+    static const char lostMarker[] = "\n[... overwritten during download ...]\n";
+    size_t prefixLen = strlen(prefix);
+    size_t written = 0;
+    
+    if (index < prefixLen) {
+        written = min(prefixLen - index, maxLen);
+        memcpy(buffer, prefix + index, written);
+        if (written == maxLen) {
+            return written;
+        }
+    }
+    
+    if (!cursor.started || cursor.next != cursor.end) {
+        if (xSemaphoreTake(consoleMutex, pdMS_TO_TICKS(10)) != pdTRUE) {
+            return written > 0 ? written : RESPONSE_TRY_AGAIN;
+        }
+        uint32_t oldest = consoleWritten - consoleUsed;
+        if (!cursor.started) {
+            cursor.started = true;
+            cursor.next = oldest;
+            cursor.end = consoleWritten;
+        }
+        
+        // Wrapped (or /clear) past where this response had got to: mark the gap, or skip
+        // it unmarked if even an empty chunk has no room for the marker
+        if ((int32_t)(oldest - cursor.next) > 0) {
+            if (maxLen - written >= sizeof(lostMarker) - 1) {
+                memcpy(buffer + written, lostMarker, sizeof(lostMarker) - 1);
+                written += sizeof(lostMarker) - 1;
+            } else if (written > 0) {
+                xSemaphoreGive(consoleMutex);
+                return written;
+            }
+            cursor.next = (int32_t)(oldest - cursor.end) < 0 ? oldest : cursor.end;
+        }
+        
+        // Copy out of the ring, which may wrap at the end of the array
+        while ((int32_t)(oldest - cursor.next) <= 0 && cursor.next != cursor.end && written < maxLen) {
+            size_t pos = (consoleHead + MAX_CONSOLE_BUFFER - (consoleWritten - cursor.next)) % MAX_CONSOLE_BUFFER;
+            size_t count = min((size_t)(cursor.end - cursor.next), maxLen - written);
+            count = min(count, (size_t)MAX_CONSOLE_BUFFER - pos);
+            memcpy(buffer + written, consoleRing + pos, count);
+            written += count;
+            cursor.next += count;
+        }
+        xSemaphoreGive(consoleMutex);
+        if (cursor.next != cursor.end) {
+            return written > 0 ? written : RESPONSE_TRY_AGAIN;
+        }
+    }
+    
+    size_t suffixLen = strlen(suffix);
+    size_t count = min(suffixLen - cursor.suffixSent, maxLen - written);
+    memcpy(buffer + written, suffix + cursor.suffixSent, count);
+    cursor.suffixSent += count;
+    return written + count;
+}
+
+// Pull OTA is only accepted with the configured token, compared in constant time
+bool otaTokenValid(AsyncWebServerRequest* request) {
+    const char* expected = OTA_TOKEN;
+    if (expected[0] == '\0' || !request->hasHeader("X-OTA-Token")) {
+        return false;
+    }
+    const String& token = request->header("X-OTA-Token");
+    size_t len = strlen(expected);
+    uint8_t diff = token.length() != len;
+    for (size_t i = 0; i < len; i++) {
+        diff |= (uint8_t)expected[i] ^ (uint8_t)(i < token.length() ? token[i] : 0);
+    }
+    return diff == 0;
+}
+
+void setupWebServer() {
+    // Console monitoring page
+    server.on("/", HTTP_GET, [](AsyncWebServerRequest *request) {
+        static const char* header =
+            "<!DOCTYPE html><html><head><title>ESP32 BTC Ticker Console</title>"
+            "<meta http-equiv='refresh' content='2'>"
+            "<style>body{font-family:monospace;background:#000;color:#0f0;padding:20px;} "
+            "pre{white-space:pre-wrap;word-wrap:break-word;}</style></head>"
+            "<body><h1>ESP32 BTC Ticker Console</h1>"
+            "<p>Auto-refresh every 2 seconds | <a href='/clear'>Clear Buffer</a> | <a href='/api/state'>State</a></p>"
+            "<pre>";
+        static const char* footer = "</pre></body></html>";
+        
+        std::shared_ptr<ConsoleCursor> cursor = std::make_shared<ConsoleCursor>();
+        request->send(request->beginChunkedResponse("text/html", [cursor](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+            return fillConsoleChunk(*cursor, buffer, maxLen, index, header, footer);
+        }));
+    });
+    
+    // API endpoint for just the console data
+    server.on("/console", HTTP_GET, [](AsyncWebServerRequest *request) {
+        std::shared_ptr<ConsoleCursor> cursor = std::make_shared<ConsoleCursor>();
+        request->send(request->beginChunkedResponse("text/plain", [cursor](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+            return fillConsoleChunk(*cursor, buffer, maxLen, index, "", "");
+        }));
+    });
+    
+    // Current price snapshot as JSON
+    server.on("/api/state", HTTP_GET, [](AsyncWebServerRequest *request) {
+        double price = 0.0, change1h = 0.0, change1d = 0.0, change24h = 0.0;
+        unsigned long updatedAt = 0;
+        const char* source = "";
+        if (xSemaphoreTake(priceMutex, pdMS_TO_TICKS(20)) == pdTRUE) {
+            price = currentBTCPrice;
+            change1h = btc1hChange;
+            change1d = btc1dChange;
+            change24h = btc24hChange;
+            updatedAt = lastPriceUpdate;
+            source = lastPriceSource;
+            xSemaphoreGive(priceMutex);
+        }
+        
+        char json[512];
+        snprintf(json, sizeof(json),
+                 "{\"price\":%.2f,\"change_1h\":%.2f,\"change_1d\":%.2f,\"change_24h\":%.2f,"
+                 "\"source\":\"%s\",\"role\":\"%s\",\"age_ms\":%lu,\"uptime_ms\":%lu,\"wifi_rssi\":%d,\"frames_dropped\":%lu,"
+                 "\"latency_p50_ms\":%lu,\"latency_p99_ms\":%lu,\"latency_max_ms\":%lu,"
+                 "\"latency_over_target\":%lu,\"latency_target_ms\":%d,\"fanout_missed\":%u,\"steady_allocs\":%ld}",
+                 price, change1h, change1d, change24h, source,
+                 fanout.role == FANOUT_LEADER ? "leader" : fanout.role == FANOUT_FOLLOWER ? "follower" : "standalone",
+                 updatedAt > 0 ? millis() - updatedAt : 0UL, millis(), WiFi.RSSI(), framePacer.missedFrames,
+                 latencyPercentileMs(50), latencyPercentileMs(99), (unsigned long)(tickLatency.maxMicros / 1000),
+                 (unsigned long)tickLatency.overTarget, LATENCY_TARGET_MS, fanout.missed, steadyAllocations());
+        request->send(200, "application/json", json);
+    });
+    
+    // Pull a (optionally gzip-compressed) firmware image from a local HTTP server
+    server.on("/ota", HTTP_POST, [](AsyncWebServerRequest *request) {
+        if (!otaTokenValid(request)) {
+            request->send(403, "text/plain", OTA_TOKEN[0] == '\0' ? "Pull OTA disabled - set OTA_TOKEN in config.h\n"
+                                                                     : "Missing or wrong X-OTA-Token header\n");
+            return;
+        }
+        if (!request->hasParam("url") || !request->hasParam("sha256")) {
+            request->send(400, "text/plain", "Usage: POST /ota?url=http://host/firmware.bin.gz&sha256=<hex of firmware.bin>\n");
+            return;
+        }
+        const String& url = request->getParam("url")->value();
+        const String& sha256 = request->getParam("sha256")->value();
+        if (url.length() >= sizeof(otaPull.url) || sha256.length() != 64) {
+            request->send(400, "text/plain", "URL too long or SHA-256 not 64 hex characters\n");
+            return;
+        }
+        if (!startOtaPull(url, sha256)) {
+            request->send(409, "text/plain", "OTA already in progress\n");
+            return;
+        }
+        request->send(202, "text/plain", "OTA started - progress on /console\n");
+    });
+    
+    // Download the binary recording (format documented in recording.h)
+    server.on("/recording", HTTP_GET, [](AsyncWebServerRequest *request) {
+        AsyncWebServerResponse *response = request->beginChunkedResponse("application/octet-stream",
+            [](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+                return fillRecordingChunk(buffer, maxLen, index);
+            });
+        response->addHeader("Content-Disposition", "attachment; filename=\"btc-ticker.rec\"");
+        request->send(response);
+    });
+    
+    // Recorder status; ?frames=1 also records rendered frames, ?frames=0 ticks only
+    server.on("/record", HTTP_POST, [](AsyncWebServerRequest *request) {
+        if (request->hasParam("frames")) {
+            bool frames = request->getParam("frames")->value() == "1";
+            if (frames && REC_KEYFRAME_INTERVAL == 0) {
+                request->send(400, "text/plain", "Frame ring too small for this wall - raise REC_FRAME_BYTES\n");
+                return;
+            }
+            recorder.framesEnabled = frames;
+        }
+        char status[224];
+        snprintf(status, sizeof(status),
+                 "ticks: %u records, %u/%u bytes, %u evicted\n"
+                 "frames: %s, %u records, %u/%u bytes, %u evicted, keyframe every %u\n",
+                 recorder.ticks.records, recorder.ticks.used, RECORDER_BYTES, recorder.ticks.evicted,
+                 recorder.framesEnabled ? "on" : "off", recorder.frames.records, recorder.frames.used, REC_FRAME_BYTES,
+                 recorder.frames.evicted, REC_KEYFRAME_INTERVAL + 1);
+        request->send(200, "text/plain", status);
+    });
+    
+    // Time fresh TLS handshakes to each price host (?n= per mode); results on /console
+    server.on("/tlsbench", HTTP_POST, [](AsyncWebServerRequest *request) {
+        int rounds = request->hasParam("n") ? request->getParam("n")->value().toInt() : 5;
+        if (tlsBenchTaskHandle != NULL) {
+            request->send(409, "text/plain", "TLS benchmark already running\n");
+            return;
+        }
+        if (!wifiConnected || otaInProgress) {
+            request->send(503, "text/plain", "TLS benchmark unavailable - WiFi down or OTA in progress\n");
+            return;
+        }
+        if (ESP.getMaxAllocHeap() < TLS_MIN_FREE_BLOCK + TLS_BENCH_TASK_STACK) {
+            request->send(503, "text/plain", "TLS benchmark unavailable - not enough contiguous heap\n");
+            return;
+        }
+        
+        // Its own short-lived task: the OHLC task doesn't exist in every configuration
+        xTaskCreatePinnedToCore(
+            tlsBenchTask,                 // Task function
+            "TLSBenchTask",               // Task name
+            TLS_BENCH_TASK_STACK,         // Stack size
+            (void*)(intptr_t)constrain(rounds, 1, TLS_BENCH_MAX_ROUNDS),  // Parameters
+            1,                            // Priority
+            &tlsBenchTaskHandle,          // Task handle
+            0                             // Core 0
+        );
+        if (tlsBenchTaskHandle == NULL) {
+            request->send(503, "text/plain", "TLS benchmark unavailable - task could not be created\n");
+            return;
+        }
+        request->send(202, "text/plain", "TLS benchmark started - results on /console\n");
+    });
+    
+    // Re-render every recorded tick at full speed; results on /console
+    server.on("/replay", HTTP_POST, [](AsyncWebServerRequest *request) {
+        replayRequested = true;
+        request->send(202, "text/plain", "Replay queued - results on /console\n");
+    });
+    
+    // Heap/stack telemetry and task right-sizing recommendations
+    server.on("/resources", HTTP_GET, [](AsyncWebServerRequest *request) {
+        std::shared_ptr<ReportCursor> cursor = std::make_shared<ReportCursor>();
+        request->send(request->beginChunkedResponse("text/plain", [cursor](uint8_t *buffer, size_t maxLen, size_t index) -> size_t {
+            return fillResourceChunk(*cursor, buffer, maxLen);
+        }));
+    });
+    
+    // Clear console buffer
+    server.on("/clear", HTTP_GET, [](AsyncWebServerRequest *request) {
+        if (xSemaphoreTake(consoleMutex, pdMS_TO_TICKS(50)) == pdTRUE) {
+            consoleUsed = 0;
+            xSemaphoreGive(consoleMutex);
+        }
+        addToConsoleBuffer("Console buffer cleared");
+        request->redirect("/");
+    });
+    
+    server.begin();
+    LOG_INFO("Web server started on http://%s.local", DEVICE_HOSTNAME);
+}
+
+// FNV-1a hash of a response body, used to skip re-parsing identical payloads
+uint32_t hashPayload(const char* body, size_t len) {
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t)body[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+// Milliseconds until an endpoint is due (0 if due now)
+unsigned long msUntilDue(const EndpointState& endpoint) {
+    long remaining = (long)(endpoint.nextFetch - millis());
+    return remaining > 0 ? remaining : 0;
+}
+
+// Split an http(s) URL into host and port. Returns the path.
+const char* parseUrlHost(const char* url, char* host, size_t hostLen, uint16_t& port) {
+    bool secure = strncmp(url, "https:", 6) == 0;
+    const char* start = strstr(url, "://");
+    start = start != NULL ? start + 3 : url;
+    size_t len = strcspn(start, ":/");
+    snprintf(host, hostLen, "%.*s", (int)len, start);
+    port = start[len] == ':' ? atoi(start + len + 1) : (secure ? 443 : 80);
+    const char* path = strchr(start, '/');
+    return path != NULL ? path : "/";
+}
+
+// Base64 SHA-256 of a certificate's SubjectPublicKeyInfo - the same value as
+// openssl x509 -pubkey -noout | openssl pkey -pubin -outform der | openssl dgst -sha256 -binary | base64
+bool publicKeyPin(const mbedtls_x509_crt* cert, char* pin, size_t pinLen) {
+    uint8_t der[600];  // Fits an RSA-4096 key; written at the end of the buffer
+    int len = mbedtls_pk_write_pubkey_der((mbedtls_pk_context*)&cert->pk, der, sizeof(der));
+    if (len <= 0) {
+        return false;
+    }
+    uint8_t digest[32];
+    mbedtls_sha256(der + sizeof(der) - len, len, digest, 0);
+    size_t written;
+    return mbedtls_base64_encode((uint8_t*)pin, pinLen, &written, digest, sizeof(digest)) == 0;
+}
+
+// Verify server chains against the CA bundle for every TLS client
+void configureTls(WiFiClientSecure& client) {
+    client.setCACertBundle(caBundle);
+}
+
+// Whether pin is one of the comma-separated entries in pins, compared whole (spaces
+// around entries ignored), so a pin that merely contains another never matches
+bool pinListed(const char* pins, const char* pin) {
+    size_t pinLen = strlen(pin);
+    const char* entry = pins;
+    while (*entry != '\0') {
+        entry += strspn(entry, " ");
+        size_t len = strcspn(entry, ",");
+        size_t trimmed = len;
+        while (trimmed > 0 && entry[trimmed - 1] == ' ') {
+            trimmed--;
+        }
+        if (trimmed == pinLen && pinLen > 0 && memcmp(entry, pin, pinLen) == 0) {
+            return true;
+        }
+        entry += len;
+        if (*entry == ',') {
+            entry++;
+        }
+    }
+    return false;
+}
+
+// Whether any certificate the server presented (leaf or intermediates) has a key in
+// pins. pin is left holding the leaf's pin for logging.
+bool chainMatchesPin(const mbedtls_x509_crt* chain, const char* pins, char* pin, size_t pinLen) {
+    char candidate[48];
+    for (const mbedtls_x509_crt* cert = chain; cert != NULL; cert = cert->next) {
+        if (!publicKeyPin(cert, candidate, sizeof(candidate))) {
+            continue;
+        }
+        if (cert == chain) {
+            snprintf(pin, pinLen, "%s", candidate);
+        }
+        if (pinListed(pins, candidate)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Open the endpoint's connection, or reuse the kept-alive one. For https the chain is
+// verified against the CA bundle during the handshake (see configureTls), and the pins,
+// if any, are checked once when the connection opens; kept-alive connections skip both
+// the handshake and the check. For https URLs, client must be a WiFiClientSecure.
+bool openPinnedConnection(WiFiClient& client, EndpointState& endpoint) {
+    if (client.connected()) {
+        endpoint.reusedConnections++;
+        return true;
+    }
+    
+    // A new connection (and its TLS session) is the one place a fetch may allocate
+    AllocScope handshake;
+    char host[64];
+    uint16_t port;
+    parseUrlHost(endpoint.url, host, sizeof(host), port);
+    unsigned long start = millis();
+    bool connected = endpoint.secure ? ((WiFiClientSecure&)client).connect(host, port) : client.connect(host, port);
+    if (!connected) {
+        LOG_WARN("%s: connect to %s:%u failed (or certificate not trusted)", endpoint.name, host, port);
+        return false;
+    }
+    unsigned long elapsed = millis() - start;
+    endpoint.handshakes++;
+    endpoint.handshakeMillis += elapsed;
+    endpoint.handshakeMaxMillis = max(endpoint.handshakeMaxMillis, (uint32_t)elapsed);
+    
+    if (!endpoint.secure || endpoint.pins == NULL || endpoint.pins[0] == '\0') {
+        return true;
+    }
+    
+    unsigned long pinStart = micros();
+    char pin[48] = "";
+    bool matched = chainMatchesPin(((WiFiClientSecure&)client).getPeerCertificate(), endpoint.pins, pin, sizeof(pin));
+    endpoint.pinMicros += micros() - pinStart;
+    
+    if (!matched) {
+        client.stop();
+        LOG_ERROR("TLS: no key in %s's chain is pinned (leaf %s) - connection refused", endpoint.name, pin);
+        return false;
+    }
+    return true;
+}
+
+// WiFiClient as a transport for the response reader in http_response.h
+struct WiFiTransport {
+    WiFiClient& client;
+    
+    int read() {
+        return client.read();
+    }
+    
+    int read(uint8_t* buffer, size_t len) {
+        return client.read(buffer, len);
+    }
+    
+    bool connected() {
+        return client.connected();
+    }
+    
+    unsigned long now() {
+        return millis();
+    }
+    
+    void idle() {
+        vTaskDelay(1);
+    }
+};
+
+// Minimal HTTP/1.1 GET on an open connection. The request is built on the stack and
+// the body lands in the caller's buffer (NUL-terminated), so nothing is allocated.
+// Handles Content-Length and chunked bodies; the connection is dropped on any error,
+// an oversized body, or "Connection: close". Returns the status code, or -1.
+int httpGet(WiFiClient& client, EndpointState& endpoint, char* body, size_t capacity, size_t& bodyLen, unsigned long& maxAge) {
+    char host[64];
+    uint16_t port;
+    const char* path = parseUrlHost(endpoint.url, host, sizeof(host), port);
+    bool withKey = endpoint.apiKey != NULL;
+    bool withEtag = endpoint.etag[0] != '\0';
+    
+    char request[HTTP_REQUEST_BYTES];
+    int requestLen = snprintf(request, sizeof(request),
+                              "GET %s HTTP/1.1\r\nHost: %s\r\nUser-Agent: " DEVICE_HOSTNAME "\r\n"
+                              "Accept-Encoding: identity\r\nConnection: keep-alive\r\n%s%s%s%s%s%s\r\n",
+                              path, host,
+                              withKey ? "x-cg-pro-api-key: " : "", withKey ? endpoint.apiKey : "", withKey ? "\r\n" : "",
+                              withEtag ? "If-None-Match: " : "", endpoint.etag, withEtag ? "\r\n" : "");
+    if (requestLen >= (int)sizeof(request) || client.write((const uint8_t*)request, requestLen) != (size_t)requestLen) {
+        client.stop();
+        return -1;
+    }
+    
+    WiFiTransport transport = {client};
+    HttpResponse response = readHttpResponse(transport, body, capacity, endpoint.pendingEtag, ETAG_BYTES,
+                                             millis() + REQUEST_TIMEOUT);
+    if (!response.keepAlive) {
+        client.stop();
+    }
+    bodyLen = response.bodyLen;
+    maxAge = response.maxAge;
+    return response.status;
+}
+
+// Conditional GET for one endpoint into the caller's body buffer. Sends If-None-Match,
+// honours Cache-Control when scheduling the next fetch, and only returns FETCH_NEW
+// (with body/bodyLen filled) when the body differs from the last one parsed. A FETCH_NEW
+// body's ETag and hash only count once the caller parses it and calls acceptPayload(),
+// so a body that fails to parse is fetched and parsed again instead of skipped.
+FetchResult fetchEndpoint(WiFiClient& client, EndpointState& endpoint, char* body, size_t capacity, size_t& bodyLen) {
+    FetchResult result = FETCH_FAILED;
+    unsigned long now = millis();
+    
+    if (!openPinnedConnection(client, endpoint)) {
+        endpoint.requests++;
+        endpoint.nextFetch = now + UPDATE_INTERVAL;  // Retry at the normal polling rate
+        return FETCH_FAILED;
+    }
+    
+    unsigned long maxAge = 0;
+    int httpCode = httpGet(client, endpoint, body, capacity, bodyLen, maxAge);
+    endpoint.respondedAt = micros();
+    endpoint.requests++;
+    
+    if (httpCode == HTTP_CODE_OK || httpCode == HTTP_CODE_NOT_MODIFIED) {
+        // Never poll faster than the server says its data can change
+        unsigned long interval = max(endpoint.baseInterval, maxAge);
+        endpoint.nextFetch = now + interval;
+        
+        if (httpCode == HTTP_CODE_NOT_MODIFIED) {
+            endpoint.notModified++;
+            result = FETCH_NOT_MODIFIED;
+        } else {
+            uint32_t hash = hashPayload(body, bodyLen);
+            if (hash == endpoint.payloadHash) {
+                strcpy(endpoint.etag, endpoint.pendingEtag);  // Same body as the parsed one
+                endpoint.unchanged++;
+                result = FETCH_UNCHANGED;
+            } else {
+                endpoint.pendingHash = hash;
+                endpoint.parsed++;
+                result = FETCH_NEW;
+            }
+        }
+    } else {
+        LOG_WARN("%s GET failed, error: %d", endpoint.name, httpCode);
+        endpoint.nextFetch = now + UPDATE_INTERVAL;  // Retry at the normal polling rate
+    }
+    
+    return result;
+}
+
+// The FETCH_NEW body parsed: later identical bodies (or a 304 for its ETag) are skipped
+void acceptPayload(EndpointState& endpoint) {
+    endpoint.payloadHash = endpoint.pendingHash;
+    strcpy(endpoint.etag, endpoint.pendingEtag);
+}
+
+// Recompute percentage changes from the latest price and OHLC reference points.
+// Caller must hold priceMutex.
+void recomputeChanges() {
+    if (currentBTCPrice <= 0) {
+        return;
+    }
+    if (price1hClose > 0) {
+        btc1hChange = ((currentBTCPrice - price1hClose) / price1hClose) * 100.0;
+    }
+    if (dailyOpen > 0) {
+        btc1dChange = ((currentBTCPrice - dailyOpen) / dailyOpen) * 100.0;
+    } else if (MARKETS_FETCH && !MARKETS_OHLC_BACKFILL) {
+        btc1dChange = btc24hChange;  // No daily candle without backfill
+    }
+}
+
+// Turn a source's rolling 1h change into the price an hour ago, so recomputeChanges()
+// keeps tracking it when other sources win later rounds. Fresh markets data
+// postpones the hourly OHLC backfill.
+void applyHourlyChange(double price, double change1h) {
+    if (xSemaphoreTake(priceMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return;
+    }
+    price1hClose = price / (1.0 + change1h / 100.0);
+    hourlyEndpoint.nextFetch = millis() + OHLC_HOURLY_REFRESH;
+    xSemaphoreGive(priceMutex);
+}
+
+// Signal the renderer that new values are ready. Keeps the arrival time of the
+// oldest unrendered response so coalesced ticks report their worst-case latency.
+// Caller must hold priceMutex.
+void publishTick(unsigned long receivedAt) {
+    if (!tickPending) {
+        tickReceivedAt = receivedAt;
+        tickPending = true;
+    }
+    recordTick();
+    broadcastSnapshot();
+    if (loopTaskHandle != NULL) {
+        xTaskNotifyGive(loopTaskHandle);
+    }
+}
+
+// Update a source's scoreboard after a request. Only successes feed the latency
+// history, so a source that fails fast doesn't look quick.
+void recordSourceOutcome(PriceSource& source, bool ok, unsigned long latencyMs) {
+    xSemaphoreTake(sourceMutex, portMAX_DELAY);
+    source.errorRate *= 0.8f;
+    if (ok) {
+        source.latencyMs[source.latencyHead] = (uint16_t)min(latencyMs, 65535UL);
+        source.latencyHead = (source.latencyHead + 1) % SOURCE_LATENCY_SAMPLES;
+        if (source.latencyCount < SOURCE_LATENCY_SAMPLES) {
+            source.latencyCount++;
+        }
+    } else {
+        source.errorRate += 0.2f;
+        source.errors++;
+    }
+    xSemaphoreGive(sourceMutex);
+}
+
+// 90th percentile of a source's recent response times, 0 with no history.
+// Caller holds sourceMutex.
+unsigned long sourceP90(const PriceSource& source) {
+    if (source.latencyCount == 0) {
+        return 0;
+    }
+    uint16_t sorted[SOURCE_LATENCY_SAMPLES];
+    memcpy(sorted, source.latencyMs, source.latencyCount * sizeof(uint16_t));
+    std::sort(sorted, sorted + source.latencyCount);
+    return sorted[(source.latencyCount * 9 + 9) / 10 - 1];
+}
+
+// Expected cost of using a source as primary: its p90, plus a request timeout weighted
+// by how often it has been failing. Untried sources score 0 so each gets sampled early.
+// Caller holds sourceMutex.
+float sourceScore(const PriceSource& source) {
+    return sourceP90(source) + source.errorRate * REQUEST_TIMEOUT;
+}
+
+// Log requests and parse time per endpoint for the last reporting period, then reset
+void reportFetchStats() {
+    static unsigned long lastReport = 0;
+    unsigned long elapsed = millis() - lastReport;
+    if (elapsed < FETCH_STATS_INTERVAL) {
+        return;
+    }
+    lastReport = millis();
+    
+    // Fixed-interval polling made one request per endpoint every UPDATE_INTERVAL
+    unsigned long legacyPerHour = 3UL * (3600000UL / UPDATE_INTERVAL);
+    unsigned long totalPerHour = 0;
+    
+    EndpointState* endpoints[PRICE_SOURCE_COUNT + 2] = {&hourlyEndpoint, &dailyEndpoint};
+    for (int i = 0; i < PRICE_SOURCE_COUNT; i++) {
+        endpoints[i + 2] = &priceSources[i].endpoint;
+    }
+    for (EndpointState* endpoint : endpoints) {
+        float hours = elapsed / 3600000.0f;
+        unsigned long requestsPerHour = (unsigned long)(endpoint->requests / hours);
+        totalPerHour += requestsPerHour;
+        
+        LOG_INFO("%s: %lu req/h (%u not modified, %u unchanged, %u parsed), parse %lu us/h",
+                 endpoint->name, requestsPerHour, endpoint->notModified, endpoint->unchanged,
+                 endpoint->parsed, (unsigned long)(endpoint->parseMicros / hours));
+        
+        // Full handshakes vs kept-alive reuse, and what the pin check adds to a handshake
+        if (endpoint->handshakes > 0) {
+            LOG_INFO("%s TLS: %u handshakes (avg %u ms, max %u ms), %u reused, pin check avg %u us",
+                     endpoint->name, endpoint->handshakes, endpoint->handshakeMillis / endpoint->handshakes,
+                     endpoint->handshakeMaxMillis, endpoint->reusedConnections, endpoint->pinMicros / endpoint->handshakes);
+        }
+        
+        endpoint->requests = endpoint->notModified = endpoint->unchanged = endpoint->parsed = 0;
+        endpoint->parseMicros = 0;
+        endpoint->handshakes = endpoint->reusedConnections = endpoint->handshakeMillis = endpoint->pinMicros = 0;
+        endpoint->handshakeMaxMillis = 0;
+    }
+    
+    LOG_INFO("Total: %lu req/h (fixed %ds polling: %lu req/h)", totalPerHour, UPDATE_INTERVAL / 1000, legacyPerHour);
+    
+    // Price source scoreboard
+    xSemaphoreTake(sourceMutex, portMAX_DELAY);
+    for (int i = 0; i < PRICE_SOURCE_COUNT; i++) {
+        PriceSource& source = priceSources[i];
+        LOG_INFO("%s: p90 %lu ms, %u wins, %u errors (rate %.2f)",
+                 source.endpoint.name, sourceP90(source), source.wins, source.errors, source.errorRate);
+        source.wins = source.errors = 0;
+    }
+    xSemaphoreGive(sourceMutex);
+    LOG_INFO("Hedges: %u fired, %u won", hedgesFired, hedgeWins);
+    hedgesFired = hedgeWins = 0;
+}
+
+// Order the idle sources best-first (see rankSources). Returns how many.
+int rankPriceSources(int* ranked) {
+    SourceCandidate candidates[PRICE_SOURCE_COUNT];
+    
+    xSemaphoreTake(sourceMutex, portMAX_DELAY);
+    for (int i = 0; i < PRICE_SOURCE_COUNT; i++) {
+        candidates[i] = {sourceScore(priceSources[i]), msUntilDue(priceSources[i].endpoint), priceSources[i].inFlight};
+    }
+    xSemaphoreGive(sourceMutex);
+    return rankSources(candidates, PRICE_DUE_TOLERANCE, ranked);
+}
+
+// How long to give a source before hedging: its recent p90, within sane bounds
+unsigned long hedgeDelayFor(int source) {
+    xSemaphoreTake(sourceMutex, portMAX_DELAY);
+    unsigned long p90 = sourceP90(priceSources[source]);
+    xSemaphoreGive(sourceMutex);
+    if (p90 == 0) {
+        return HEDGE_DEFAULT_DELAY;
+    }
+    return constrain(p90, (unsigned long)HEDGE_MIN_DELAY, REQUEST_TIMEOUT);
+}
+
+// Hand a source to an idle fetch lane. Returns false if every lane is busy.
+bool dispatchPriceRequest(uint32_t round, int source) {
+    for (int lane = 0; lane < PRICE_LANES; lane++) {
+        if (!laneBusy[lane]) {
+            laneBusy[lane] = true;
+            priceSources[source].inFlight = true;
+            PriceRequest request = {round, (uint8_t)source};
+            xQueueSend(laneRequests[lane], &request, 0);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Publish a winning price to the display
+void publishPrice(const PriceResult& result) {
+    if (xSemaphoreTake(priceMutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return;
+    }
+    
+    // Round to nearest cent
+    currentBTCPrice = round(result.price * 100.0) / 100.0;
+    btc24hChange = round(result.change24h * 100.0) / 100.0;
+    lastPriceUpdate = millis();
+    lastPriceSource = priceSources[result.source].endpoint.name;
+    
+    // 1h/1d changes track the live price against cached OHLC references
+    recomputeChanges();
+    publishTick(result.respondedAt);
+    
+    LOG_INFO("BTC price: $%.2f USD, 24h: %+.2f%% (%s)", currentBTCPrice, btc24hChange, lastPriceSource);
+    xSemaphoreGive(priceMutex);
+}
+
+// The price task's view of the fetch lanes for one round (see runHedgedRound)
+struct PriceRoundLanes {
+    uint32_t round;
+    PriceResult result;  // Last answer for this round; the winner's once the round ends
+    
+    unsigned long now() {
+        return millis();
+    }
+    
+    bool dispatch(int source) {
+        return dispatchPriceRequest(round, source);
+    }
+    
+    bool await(unsigned long waitMs, int& source, bool& good) {
+        if (xQueueReceive(laneResults, &result, pdMS_TO_TICKS(waitMs)) != pdTRUE || result.round != round) {
+            return false;
+        }
+        source = result.source;
+        good = result.fetch != FETCH_FAILED && (result.fetch != FETCH_NEW || result.valid);
+        return true;
+    }
+    
+    void hedged(int primary, int hedge, unsigned long elapsed) {
+        hedgesFired++;
+        LOG_DEBUG("%s slow after %lu ms, hedging with %s",
+                  priceSources[primary].endpoint.name, elapsed, priceSources[hedge].endpoint.name);
+    }
+};
+
+// One hedged price round. The best-scoring source goes out first; once it is past its
+// p90 the next one is fired on the other lane, and the first good answer wins. Slower
+// answers still land on the scoreboard but are otherwise ignored.
+void runPriceRound(uint32_t round) {
+    int ranked[PRICE_SOURCE_COUNT];
+    int candidates = rankPriceSources(ranked);
+    
+    // Drop answers that arrived after their round ended
+    PriceRoundLanes lanes = {round};
+    while (xQueueReceive(laneResults, &lanes.result, 0) == pdTRUE) {
+    }
+    
+    unsigned long hedgeDelay = candidates > 0 ? hedgeDelayFor(ranked[0]) : 0;
+    RoundOutcome outcome = runHedgedRound(lanes, ranked, candidates, hedgeDelay, REQUEST_TIMEOUT, PRICE_HEDGING);
+    
+    if (outcome.winner >= 0 && lanes.result.valid) {
+        publishPrice(lanes.result);
+    }
+    if (outcome.hedged && outcome.winner >= 0 && outcome.winner != ranked[0]) {
+        hedgeWins++;
+    }
+    if (outcome.winner < 0 && candidates > 0) {
+        LOG_WARN("No price source answered this round");
+    }
+    
+    xSemaphoreTake(sourceMutex, portMAX_DELAY);
+    if (outcome.winner >= 0) {
+        priceSources[outcome.winner].wins++;
+    }
+    // Let sources that sat this round out recover from old errors so they get retried
+    for (int i = outcome.dispatched; i < candidates; i++) {
+        priceSources[ranked[i]].errorRate *= 0.95f;
+    }
+    xSemaphoreGive(sourceMutex);
+}
+
+// Fetch lane: runs one source request at a time for the price task and posts the
+// outcome. Each lane has its own clients, so a stalled request never blocks the other.
+void priceLaneTask(void *pvParameters) {
+    int lane = (int)(intptr_t)pvParameters;
+    char* body = laneBodies[lane];
+    WiFiClientSecure secureClient;
+    WiFiClient plainClient;
+    configureTls(secureClient);
+    
+    PriceRequest request;
+    int lastSource = -1;
+    while (true) {
+        if (xQueueReceive(laneRequests[lane], &request, portMAX_DELAY) != pdTRUE) {
+            continue;
+        }
+        PriceSource& source = priceSources[request.source];
+        
+        // Plain http:// lets a source be pointed at a local stand-in server
+        WiFiClient& client = source.endpoint.secure ? (WiFiClient&)secureClient : plainClient;
+        
+        // A kept-alive connection is only reusable for the same source
+        if (request.source != lastSource) {
+            secureClient.stop();
+            plainClient.stop();
+            lastSource = request.source;
+        }
+        
+        PriceResult result = {request.round, request.source, FETCH_FAILED, false, 0.0, 0.0, NAN, 0};
+        size_t bodyLen = 0;
+        unsigned long start = millis();
+        result.fetch = fetchEndpoint(client, source.endpoint, body, PRICE_BODY_BYTES, bodyLen);
+        result.respondedAt = source.endpoint.respondedAt;
+        unsigned long latency = millis() - start;
+        
+        if (result.fetch == FETCH_NEW) {
+            unsigned long parseStart = micros();
+            result.valid = source.parse(body, bodyLen, result.price, result.change24h, result.change1h);
+            source.endpoint.parseMicros += micros() - parseStart;
+            if (result.valid) {
+                acceptPayload(source.endpoint);
+            }
+        }
+        
+        // Applied even if another source wins the round - it's still the freshest 1h reference
+        if (result.valid && !isnan(result.change1h)) {
+            applyHourlyChange(result.price, result.change1h);
+        }
+        
+        recordSourceOutcome(source, result.fetch != FETCH_FAILED && (result.fetch != FETCH_NEW || result.valid), latency);
+        source.inFlight = false;
+        laneBusy[lane] = false;
+        xQueueSend(laneResults, &result, 0);
+    }
+}
+
+// Task function for fetching BTC price (runs on separate core): runs a hedged round
+// every UPDATE_INTERVAL across the price sources
+void fetchBTCPriceTask(void *pvParameters) {
+    uint32_t round = 0;
+    unsigned long nextRound = 0;
+    
+    while (true) {
+        // Skip HTTP requests during OTA to avoid conflicts
+        // Followers render the fan-out leader's broadcasts instead
+        if (wifiConnected && !otaInProgress && fanout.role != FANOUT_FOLLOWER && (long)(millis() - nextRound) >= 0) {
+            nextRound = millis() + UPDATE_INTERVAL;
+            priceRequestInProgress = true;
+            runPriceRound(++round);
             priceRequestInProgress = false;
+            reportFetchStats();
         }
         
-        // Wait 30 seconds before next request (adjust as needed)
-        vTaskDelay(pdMS_TO_TICKS(UPDATE_INTERVAL));
+        // Sleep until the next round (at least briefly, so OTA/WiFi changes are noticed)
+        vTaskDelay(pdMS_TO_TICKS(max((long)(nextRound - millis()), 100L)));
     }
 }
 
 // Task function for fetching OHLC data
 void fetchOHLCDataTask(void *pvParameters) {
-    HTTPClient httpHourly, httpDaily;
     WiFiClientSecure client;
-    client.setInsecure();
+    configureTls(client);
     
     while (true) {
         // Skip HTTP requests during OTA to avoid conflicts
-        if (wifiConnected && !ohlcHourlyRequestInProgress && !otaInProgress) {
+        if (wifiConnected && !ohlcHourlyRequestInProgress && !otaInProgress && fanout.role != FANOUT_FOLLOWER) {
             ohlcHourlyRequestInProgress = true;
             
-            // Fetch hourly data
-            httpHourly.begin(client, "https://pro-api.coingecko.com/api/v3/coins/bitcoin/ohlc?vs_currency=usd&days=1&interval=hourly");
-            httpHourly.addHeader("x-cg-pro-api-key", COINGECKO_API_KEY);
-            
-            int httpCode = httpHourly.GET();
-            if (httpCode == HTTP_CODE_OK) {
-                String payload = httpHourly.getString();
+            // Fetch hourly data (into this task's body buffer and JSON arena)
+            size_t bodyLen = 0;
+            if (msUntilDue(hourlyEndpoint) == 0 &&
+                fetchEndpoint(client, hourlyEndpoint, ohlcBody, OHLC_BODY_BYTES, bodyLen) == FETCH_NEW) {
+                unsigned long parseStart = micros();
                 
-                DynamicJsonDocument doc(8192);
-                if (deserializeJson(doc, payload) == DeserializationError::Ok) {
-                    if (doc.is<JsonArray>() && doc.size() >= 1) {
-                        JsonArray ohlcArray = doc.as<JsonArray>();
+                if (deserializeJson(ohlcDoc, ohlcBody, bodyLen) == DeserializationError::Ok) {
+                    if (ohlcDoc.is<JsonArray>() && ohlcDoc.size() >= 1) {
+                        JsonArray ohlcArray = ohlcDoc.as<JsonArray>();
                         int dataPoints = ohlcArray.size();
                         
                         if (dataPoints >= 1) {
-                            double price1hClose = ohlcArray[dataPoints - 1][4];
+                            double close = ohlcArray[dataPoints - 1][4];
+                            acceptPayload(hourlyEndpoint);
                             
                             if (xSemaphoreTake(priceMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-                                btc1hChange = ((currentBTCPrice - price1hClose) / price1hClose) * 100.0;
-                                                            Serial.printf("[TASK] 1h change: %+.2f%%\n", btc1hChange);
-                            addToConsoleBuffer("1h change: " + String(btc1hChange, 2) + "%");
-                            xSemaphoreGive(priceMutex);
+                                price1hClose = close;
+                                recomputeChanges();
+                                publishTick(hourlyEndpoint.respondedAt);
+                                LOG_INFO("1h change: %+.2f%%", btc1hChange);
+                                xSemaphoreGive(priceMutex);
                             }
                         }
                     }
                 }
+                
+                hourlyEndpoint.parseMicros += micros() - parseStart;
+                
+                // Small delay between requests
+                vTaskDelay(pdMS_TO_TICKS(2000));
             }
-            httpHourly.end();
-            
-            // Small delay between requests
-            vTaskDelay(pdMS_TO_TICKS(2000));
             
             // Fetch daily data
-            httpDaily.begin(client, "https://pro-api.coingecko.com/api/v3/coins/bitcoin/ohlc?vs_currency=usd&days=1&interval=daily");
-            httpDaily.addHeader("x-cg-pro-api-key", COINGECKO_API_KEY);
-            
-            httpCode = httpDaily.GET();
-            if (httpCode == HTTP_CODE_OK) {
-                String payload = httpDaily.getString();
+            if (msUntilDue(dailyEndpoint) == 0 &&
+                fetchEndpoint(client, dailyEndpoint, ohlcBody, OHLC_BODY_BYTES, bodyLen) == FETCH_NEW) {
+                unsigned long parseStart = micros();
                 
-                DynamicJsonDocument doc(2048);
-                if (deserializeJson(doc, payload) == DeserializationError::Ok) {
-                    if (doc.is<JsonArray>() && doc.size() >= 1) {
-                        JsonArray ohlcArray = doc.as<JsonArray>();
-                        double dailyOpen = ohlcArray[0][1];
+                if (deserializeJson(ohlcDoc, ohlcBody, bodyLen) == DeserializationError::Ok) {
+                    if (ohlcDoc.is<JsonArray>() && ohlcDoc.size() >= 1) {
+                        JsonArray ohlcArray = ohlcDoc.as<JsonArray>();
+                        double open = ohlcArray[0][1];
+                        acceptPayload(dailyEndpoint);
                         
                         if (xSemaphoreTake(priceMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-                            btc1dChange = ((currentBTCPrice - dailyOpen) / dailyOpen) * 100.0;
-                            Serial.printf("[TASK] 1d change: %+.2f%%\n", btc1dChange);
-                            addToConsoleBuffer("1d change: " + String(btc1dChange, 2) + "%");
+                            dailyOpen = open;
+                            recomputeChanges();
+                            publishTick(dailyEndpoint.respondedAt);
+                            LOG_INFO("1d change: %+.2f%%", btc1dChange);
                             xSemaphoreGive(priceMutex);
                         }
                     }
                 }
+                
+                dailyEndpoint.parseMicros += micros() - parseStart;
             }
-            httpDaily.end();
             
             ohlcHourlyRequestInProgress = false;
         }
         
-        // Wait 60 seconds before next OHLC request
-        vTaskDelay(pdMS_TO_TICKS(UPDATE_INTERVAL));
+        // Sleep until whichever OHLC endpoint is due first
+        unsigned long sleepMs = min(msUntilDue(hourlyEndpoint), msUntilDue(dailyEndpoint));
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(max(sleepMs, 1000UL)));
     }
 }
 
-void setMatrixFont(FontType fontType) {
-    switch(fontType) {
-        case FONT_BUILTIN:
-            matrix->setFont(); // Reset to built-in font
-            matrix->setTextSize(1);
-            break;
-        case FONT_TOMTHUMB:
-            matrix->setFont(&TomThumb);
-            break;
-        // // NUMBERS ONLY fonts (ultra compact for price display)
-        // case FONT_2X5_NUM:
-        //     matrix->setFont(&Font2x5FixedMonoNum);
-        //     break;
-        // case FONT_3X5_NUM:
-        //     matrix->setFont(&Font3x5FixedNum);
-        //     break;
-        // case FONT_3X7_NUM:
-        //     matrix->setFont(&Font3x7FixedNum);
-        //     break;
-        // // FULL CHARACTER SET fonts (numbers + letters)
-        // case FONT_4X5_FIXED:
-        //     matrix->setFont(&Font4x5Fixed);
-        //     break;
-        // case FONT_4X7_FIXED:
-        //     matrix->setFont(&Font4x7Fixed);
-        //     break;
-        // case FONT_5X5_FIXED:
-        //     matrix->setFont(&Font5x5Fixed);
-        //     break;
-        // case FONT_5X7_FIXED:
-        //     matrix->setFont(&Font5x7Fixed);
-        //     break;
-        // case FONT_5X7_MONO:
-        //     matrix->setFont(&Font5x7FixedMono);
-        //     break;
-        default:
-            matrix->setFont(); // Default to built-in
-            matrix->setTextSize(1);
-            break;
+// One handshake on a bare mbedTLS client (no verification), offering session if it
+// holds one, which is refreshed from the new connection. WiFiClientSecure runs connect()
+// start to finish with no way to hand it a saved session, hence the raw client here.
+// Returns the handshake time in ms, or -1 on failure; resumed tells whether the server
+// accepted the session. Reads handshake->resume, a public field in mbedTLS 2.x (the
+// version arduino-esp32 2.x ships).
+long timedResumableHandshake(const char* host, const char* port, mbedtls_ctr_drbg_context* drbg,
+                             mbedtls_ssl_session* session, bool& resumed) {
+    mbedtls_net_context net;
+    mbedtls_ssl_config conf;
+    mbedtls_ssl_context ssl;
+    mbedtls_net_init(&net);
+    mbedtls_ssl_config_init(&conf);
+    mbedtls_ssl_init(&ssl);
+    long elapsed = -1;
+    resumed = false;
+    
+    unsigned long start = millis();
+    if (mbedtls_ssl_config_defaults(&conf, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM,
+                                    MBEDTLS_SSL_PRESET_DEFAULT) == 0) {
+        mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_NONE);
+        mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, drbg);
+        if (mbedtls_net_connect(&net, host, port, MBEDTLS_NET_PROTO_TCP) == 0 &&
+            mbedtls_ssl_setup(&ssl, &conf) == 0 && mbedtls_ssl_set_hostname(&ssl, host) == 0) {
+            mbedtls_ssl_set_bio(&ssl, &net, mbedtls_net_send, mbedtls_net_recv, NULL);
+            if (session->ciphersuite != 0) {
+                mbedtls_ssl_set_session(&ssl, session);
+            }
+            
+            // Step the handshake so the resume flag can be read before it is torn down
+            int ret = 0;
+            while (ssl.state != MBEDTLS_SSL_HANDSHAKE_OVER &&
+                   ((ret = mbedtls_ssl_handshake_step(&ssl)) == 0 ||
+                    ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE)) {
+                if (ssl.handshake != NULL && ssl.handshake->resume) {
+                    resumed = true;
+                }
+            }
+            if (ssl.state == MBEDTLS_SSL_HANDSHAKE_OVER) {
+                elapsed = millis() - start;
+                mbedtls_ssl_session_free(session);
+                mbedtls_ssl_session_init(session);
+                mbedtls_ssl_get_session(&ssl, session);
+                mbedtls_ssl_close_notify(&ssl);
+            }
+        }
     }
+    
+    mbedtls_ssl_free(&ssl);
+    mbedtls_ssl_config_free(&conf);
+    mbedtls_net_free(&net);
+    return elapsed;
 }
 
-void updateMultiColorScrollingText(int16_t y, ScrollState& scrollState, FontType fontType) {
-    // Only update if enough time has passed
-    if (scrollState.shouldUpdate()) {
-        setMatrixFont(fontType);
-        
-        // Clear only the scrolling text area (bottom line)
-        matrix->fillRect(0, y-6, 32, 8, 0);  // Clear bottom text area
-        
-        // Format each timeframe with its value (now only 3 segments)
-        char timeframes[3][16];
-        sprintf(timeframes[0], "1H: %+.1f%%", btc1hChange);
-        sprintf(timeframes[1], "1D: %+.1f%%", btc1dChange);
-        sprintf(timeframes[2], "24H: %+.1f%%", btc24hChange);
-        
-        // Get colors for each timeframe based on sign (now only 3 colors)
-        uint16_t colors[3];
-        colors[0] = (btc1hChange >= 0) ? matrix->Color(0, 255, 0) : matrix->Color(255, 0, 0);
-        colors[1] = (btc1dChange >= 0) ? matrix->Color(0, 255, 0) : matrix->Color(255, 0, 0);
-        colors[2] = (btc24hChange >= 0) ? matrix->Color(0, 255, 0) : matrix->Color(255, 0, 0);
-        
-        // Calculate text bounds for each segment
-        int16_t x1, y1;
-        uint16_t segmentWidths[3], textHeight;
-        int16_t totalWidth = 0;
-        
-        for (int i = 0; i < 3; i++) {
-            matrix->getTextBounds(timeframes[i], 0, 0, &x1, &y1, &segmentWidths[i], &textHeight);
-            totalWidth += segmentWidths[i];
-            if (i < 2) totalWidth += 8; // Add spacing between segments (only between 1H-1D and 1D-24H)
+// Time rounds fresh TLS handshakes to each https price host in three modes: no
+// verification, chain verified against the CA bundle, and the pin check on top. A
+// fourth mode primes a session with one full handshake and then times rounds
+// reconnects that offer it, counting how many the server actually resumed.
+void runTlsBenchmark(int rounds) {
+    static const char* modes[] = {"insecure", "CA bundle", "CA + pins"};
+    AllocScope benchmark;
+    
+    // Off the stack - only one benchmark runs at a time
+    static mbedtls_entropy_context entropy;
+    static mbedtls_ctr_drbg_context drbg;
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ctr_drbg_init(&drbg);
+    bool seeded = mbedtls_ctr_drbg_seed(&drbg, mbedtls_entropy_func, &entropy, NULL, 0) == 0;
+    
+    for (int i = 0; i < PRICE_SOURCE_COUNT; i++) {
+        const EndpointState& endpoint = priceSources[i].endpoint;
+        if (!endpoint.secure) {
+            continue;
         }
+        char host[64];
+        uint16_t port;
+        parseUrlHost(endpoint.url, host, sizeof(host), port);
         
-        // Draw each timeframe segment at its position
-        int16_t currentX = scrollState.offset;
-        for (int i = 0; i < 3; i++) {
-            matrix->setTextColor(colors[i]);
-            matrix->setCursor(currentX, y);
-            matrix->print(timeframes[i]);
-            currentX += segmentWidths[i] + 8; // Move to next segment position
+        for (int mode = 0; mode < 3; mode++) {
+            // A fresh client per mode: setCACertBundle() doesn't undo setInsecure()
+            WiFiClientSecure client;
+            if (mode == 0) {
+                client.setInsecure();
+            } else {
+                configureTls(client);
+            }
+            
+            unsigned long totalMs = 0, maxMs = 0, pinMicros = 0;
+            int ok = 0;
+            for (int n = 0; n < rounds; n++) {
+                unsigned long start = millis();
+                if (!client.connect(host, port)) {
+                    continue;
+                }
+                unsigned long elapsed = millis() - start;
+                if (mode == 2) {
+                    unsigned long pinStart = micros();
+                    char pin[48] = "";
+                    chainMatchesPin(client.getPeerCertificate(), endpoint.pins != NULL ? endpoint.pins : "", pin, sizeof(pin));
+                    pinMicros += micros() - pinStart;
+                }
+                client.stop();
+                totalMs += elapsed;
+                maxMs = max(maxMs, elapsed);
+                ok++;
+            }
+            LOG_INFO("TLS bench %s, %s: %d connected, avg %lu ms, max %lu ms, pin check avg %lu us",
+                     endpoint.name, modes[mode], ok, ok > 0 ? totalMs / ok : 0UL, maxMs, ok > 0 ? pinMicros / ok : 0UL);
         }
         
-        scrollState.update();  // Move scroll position
-        
-        // Reset when entire multi-segment text has scrolled off-screen
-        if (scrollState.offset < -totalWidth) {
-            scrollState.reset(32);
+        if (!seeded) {
+            continue;
+        }
+        char portText[8];
+        snprintf(portText, sizeof(portText), "%u", port);
+        mbedtls_ssl_session session;
+        mbedtls_ssl_session_init(&session);
+        bool resumed;
+        long fullMs = timedResumableHandshake(host, portText, &drbg, &session, resumed);
+        unsigned long totalMs = 0, maxMs = 0;
+        int ok = 0, resumedCount = 0;
+        for (int n = 0; n < rounds && fullMs >= 0; n++) {
+            long elapsed = timedResumableHandshake(host, portText, &drbg, &session, resumed);
+            if (elapsed < 0) {
+                continue;
+            }
+            totalMs += elapsed;
+            maxMs = max(maxMs, (unsigned long)elapsed);
+            ok++;
+            resumedCount += resumed;
+        }
+        mbedtls_ssl_session_free(&session);
+        LOG_INFO("TLS bench %s, resumed: full %ld ms, then %d connected (%d resumed), avg %lu ms, max %lu ms",
+                 endpoint.name, fullMs, ok, resumedCount, ok > 0 ? totalMs / ok : 0UL, maxMs);
+    }
+    
+    mbedtls_ctr_drbg_free(&drbg);
+    mbedtls_entropy_free(&entropy);
+}
+
+// One-off task behind POST /tlsbench; the rounds come in as the task parameter
+void tlsBenchTask(void *pvParameters) {
+    runTlsBenchmark((int)(intptr_t)pvParameters);
+    tlsBenchTaskHandle = NULL;
+    vTaskDelete(NULL);
+}
+
+void setMatrixFont(FontType fontType) {
+    applyFont(*matrix, fontType);
+}
+
+// Register one FastLED controller driving the output-th run of LEDS_PER_OUTPUT LEDs
+template <uint8_t PIN>
+void addLedOutput(int output) {
+    FastLED.addLeds<LED_TYPE, PIN, COLOR_ORDER>(leds + output * LEDS_PER_OUTPUT, LEDS_PER_OUTPUT).setCorrection(TypicalLEDStrip);
+}
+
+// Cache the matrix's tile/panel mapping for direct leds[] writes
+void buildLedIndex() {
+    for (int16_t y = 0; y < MATRIX_HEIGHT; y++) {
+        for (int16_t x = 0; x < MATRIX_WIDTH; x++) {
+            ledIndex[y][x] = matrix->XY(x, y);
+        }
+    }
+}
+
+// Font selection for any GFX surface (matrix or off-screen canvas)
+void applyFont(Adafruit_GFX& gfx, FontType fontType) {
+    const GFXfont* font = fontType < FONT_COUNT ? fontTable[fontType] : NULL;
+    gfx.setFont(font);
+    if (font == NULL) {
+        gfx.setTextSize(1);  // Built-in font
+    }
+}
+
+// Boot log: flash used by each registered font and what subsetting saved
+void reportFontSizes() {
+    static const struct { const char* name; uint32_t fullBytes; uint32_t subsetBytes; } sizes[] = {
+#define FONT_SIZE(id, font, fullBytes, subsetBytes) {#font, fullBytes, subsetBytes},
+        FONT_REGISTRY(FONT_SIZE)
+#undef FONT_SIZE
+    };
+    for (const auto& size : sizes) {
+        if (size.fullBytes == 0) {
+            Serial.printf("Font %s: full font (no glyph subset)\n", size.name);
+            continue;
         }
+        Serial.printf("Font %s: %u bytes, %u saved by glyph subsetting\n",
+                      size.name, size.subsetBytes, size.fullBytes - size.subsetBytes);
+    }
+}
+
+// Prepare a scrolling text line for drawing. Returns the surface to draw on and
+// adjusts x/y to that surface's coordinates. With SCROLL_SUBPIXEL the line is drawn
+// one pixel right of its integer offset into scrollCanvas and blended by endScrollStrip().
+Adafruit_GFX& beginScrollStrip(int16_t top, const ScrollState& scrollState, int16_t& x, int16_t& y) {
+#if SCROLL_SUBPIXEL
+    scrollCanvas.fillScreen(0);
+    scrollCanvas.setTextWrap(false);
+    x = scrollState.offset() + 1;
+    y -= top;
+    return scrollCanvas;
+#else
+    matrix->fillRect(0, top, MATRIX_WIDTH, SCROLL_STRIP_HEIGHT, 0);
+    matrix->setTextWrap(false);
+    x = scrollState.offset();
+    return *matrix;
+#endif
+}
+
+// Composite the scroll strip onto the matrix (blend in scroll_blend.h)
+void endScrollStrip(int16_t top, const ScrollState& scrollState) {
+#if SCROLL_SUBPIXEL
+    blendScrollStrip<MATRIX_WIDTH, MATRIX_HEIGHT>(scrollCanvas.getBuffer(), SCROLL_STRIP_HEIGHT, top,
+                                                 scrollState.fraction(), ledIndex, leds);
+#endif
+}
+
+void updateMultiColorScrollingText(int16_t y, ScrollState& scrollState, FontType fontType, unsigned long now) {
+    // Advance by elapsed time - redrawn every frame so motion stays smooth
+    scrollState.advance(now);
+    setMatrixFont(fontType);
+    
+    // Format each timeframe with its value (now only 3 segments)
+    char timeframes[3][16];
+    sprintf(timeframes[0], "1H: %+.1f%%", renderSnapshot.change1h);
+    sprintf(timeframes[1], "1D: %+.1f%%", renderSnapshot.change1d);
+    sprintf(timeframes[2], "24H: %+.1f%%", renderSnapshot.change24h);
+    
+    // Get colors for each timeframe based on sign (now only 3 colors)
+    uint16_t colors[3];
+    colors[0] = (renderSnapshot.change1h >= 0) ? matrix->Color(0, 255, 0) : matrix->Color(255, 0, 0);
+    colors[1] = (renderSnapshot.change1d >= 0) ? matrix->Color(0, 255, 0) : matrix->Color(255, 0, 0);
+    colors[2] = (renderSnapshot.change24h >= 0) ? matrix->Color(0, 255, 0) : matrix->Color(255, 0, 0);
+    
+    // Calculate text bounds for each segment; the strip starts at the tallest one's top
+    int16_t x1, y1, top = y;
+    uint16_t segmentWidths[3], textHeight;
+    int16_t totalWidth = 0;
+    
+    for (int i = 0; i < 3; i++) {
+        matrix->getTextBounds(timeframes[i], 0, y, &x1, &y1, &segmentWidths[i], &textHeight);
+        top = min(top, y1);
+        totalWidth += segmentWidths[i];
+        if (i < 2) totalWidth += 8; // Add spacing between segments (only between 1H-1D and 1D-24H)
+    }
+    
+    // Reset when entire multi-segment text has scrolled off-screen
+    scrollState.wrap(MATRIX_WIDTH, totalWidth);
+    
+    // Clear only the scrolling text area (bottom line) and draw each segment
+    int16_t currentX, cursorY = y;
+    Adafruit_GFX& surface = beginScrollStrip(top, scrollState, currentX, cursorY);
+    applyFont(surface, fontType);
+    for (int i = 0; i < 3; i++) {
+        surface.setTextColor(colors[i]);
+        surface.setCursor(currentX, cursorY);
+        surface.print(timeframes[i]);
+        currentX += segmentWidths[i] + 8; // Move to next segment position
     }
+    endScrollStrip(top, scrollState);
 }
 
 
+// Draw the ticker (price + scrolling changes) from renderSnapshot at time now.
+// Shared by loop() and recording replay.
+void renderTicker(ScrollState& scrollState, unsigned long now) {
+    if (renderSnapshot.price <= 0) {
+        return;
+    }
+    
+    // Clear price area to prevent ghosting
+    matrix->fillRect(0, 0, MATRIX_WIDTH, MATRIX_HEIGHT / 2, 0);  // Clear top price area
+    
+    // Display BTC price centered at top (white, whole number)
+    char priceStr[16];
+    sprintf(priceStr, "%.0f", renderSnapshot.price);  // Whole number, no decimals
+    uint16_t white = matrix->Color(255, 255, 255);
+    printTextCentered(MATRIX_WIDTH, PRICE_BASELINE, priceStr, PRICE_FONT, white);
+    
+    // Display scrolling multi-timeframe changes at bottom (each interval color-coded)
+    updateMultiColorScrollingText(CHANGES_BASELINE, scrollState, CHANGES_FONT, now);
+}
+
 void printText(int16_t x, int16_t y, const char* text, FontType fontType, uint16_t color) {
     setMatrixFont(fontType);
     matrix->setTextColor(color);
@@ -932,31 +3028,35 @@ void printNumberCentered(int16_t width, int16_t y, const char* number, FontType
 }
 
 void printScrollingText(int16_t y, const char* text, ScrollState& scrollState, FontType fontType, uint16_t color) {
+    // The strip starts at the top of the text's bounding box
     setMatrixFont(fontType);
-    matrix->setTextWrap(false);   // Enable wrapping for scrolling
-    matrix->setTextColor(color);
-    matrix->setCursor(scrollState.offset, y);
-    matrix->print(text);
+    int16_t x1, top;
+    uint16_t w, h;
+    matrix->getTextBounds(text, 0, y, &x1, &top, &w, &h);
+    
+    int16_t x, cursorY = y;
+    Adafruit_GFX& surface = beginScrollStrip(top, scrollState, x, cursorY);
+    applyFont(surface, fontType);
+    surface.setTextColor(color);
+    surface.setCursor(x, cursorY);
+    surface.print(text);
+    endScrollStrip(top, scrollState);
 }
 
 void updateScrollingText(int16_t y, const char* text, ScrollState& scrollState, int16_t resetOffset, FontType fontType, uint16_t color) {
-    // Only update if enough time has passed based on the scroll state's speed
+    // Advance by elapsed time, then draw at the new position
+    scrollState.advance(millis());
+    
+    // Calculate text width for continuous scrolling
+    setMatrixFont(fontType);
+    int16_t x1, y1;
+    uint16_t textWidth, textHeight;
+    matrix->getTextBounds(text, 0, 0, &x1, &y1, &textWidth, &textHeight);
+    
+    // Reset when entire text has scrolled off-screen (continuous wrapping)
+    scrollState.wrap(resetOffset, (int16_t)textWidth);
+    
     printScrollingText(y, text, scrollState, fontType, color);
-    if (scrollState.shouldUpdate()) {
-        
-        scrollState.update();  // Move scroll position
-        
-        // Calculate text width for continuous scrolling
-        setMatrixFont(fontType);
-        int16_t x1, y1;
-        uint16_t textWidth, textHeight;
-        matrix->getTextBounds(text, 0, 0, &x1, &y1, &textWidth, &textHeight);
-        
-        // Reset when entire text has scrolled off-screen (continuous wrapping)
-        if (scrollState.offset < -((int16_t)textWidth)) {
-            scrollState.reset(32);  // Start from right edge again
-        }
-    }
 }
 
 // HTTP Task Management Functions for OTA Safety
@@ -966,6 +3066,11 @@ void suspendHttpTasks() {
     
     if (priceTaskHandle != NULL) {
         vTaskSuspend(priceTaskHandle);
+        for (int lane = 0; lane < PRICE_LANES; lane++) {
+            if (priceLaneHandles[lane] != NULL) {
+                vTaskSuspend(priceLaneHandles[lane]);
+            }
+        }
         Serial.println("Price task suspended.");
         addToConsoleBuffer("Price task suspended.");
     }
@@ -986,6 +3091,11 @@ void resumeHttpTasks() {
     addToConsoleBuffer("Resuming HTTP tasks after OTA...");
     
     if (priceTaskHandle != NULL) {
+        for (int lane = 0; lane < PRICE_LANES; lane++) {
+            if (priceLaneHandles[lane] != NULL) {
+                vTaskResume(priceLaneHandles[lane]);
+            }
+        }
         vTaskResume(priceTaskHandle);
         Serial.println("Price task resumed.");
         addToConsoleBuffer("Price task resumed.");
@@ -1001,3 +3111,556 @@ void resumeHttpTasks() {
     Serial.println("All HTTP tasks resumed successfully.");
     addToConsoleBuffer("All HTTP tasks resumed successfully.");
 }
+
+// LAN Fan-out Functions
+
+// Price age this device advertises as leader. Caller holds priceMutex.
+uint32_t fanoutAge() {
+    unsigned long now = millis();
+    return fanout.advertisedAge(currentBTCPrice > 0, lastPriceUpdate > 0 ? now - lastPriceUpdate : 0, now);
+}
+
+// Have the fan-out task multicast the new snapshot if this device leads. The send
+// happens there because lwIP allocates a buffer for every datagram it sends.
+void broadcastSnapshot() {
+    if (fanout.role == FANOUT_LEADER && fanoutTaskHandle != NULL) {
+        xTaskNotifyGive(fanoutTaskHandle);
+    }
+}
+
+// Multicast the current snapshot, flagged as a bare heartbeat while there is no
+// price yet. Caller holds priceMutex.
+void sendSnapshot() {
+    FanoutPacket packet;
+    encodeFanoutPacket(packet, fanout.selfId, ++fanoutSequence, fanoutAge(),
+                       currentBTCPrice, btc1hChange, btc1dChange, btc24hChange);
+    fanoutUdp.writeTo((const uint8_t*)&packet, sizeof(packet), FANOUT_GROUP, FANOUT_PORT);
+}
+
+// Runs on the AsyncUDP task for every datagram on the fan-out group. Election state
+// is shared with fanoutTask, so both only touch it under priceMutex.
+void handleFanoutPacket(AsyncUDPPacket& udpPacket) {
+    FanoutPacket packet;
+    if (!decodeFanoutPacket(udpPacket.data(), udpPacket.length(), packet)) {
+        return;  // Foreign traffic or another protocol version
+    }
+    if (xSemaphoreTake(priceMutex, pdMS_TO_TICKS(50)) != pdTRUE) {
+        return;  // The next heartbeat repeats it
+    }
+    
+    FanoutAction action = fanout.onPacket(packet, fanoutAge(), millis());
+    if (action == FANOUT_NEW_LEADER) {
+        LOG_INFO("Fan-out: following leader %08x", packet.leaderId);
+    }
+    
+    // Heartbeats repeat the last snapshot - only changed values become a tick
+    if (action != FANOUT_IGNORE && !(packet.flags & FANOUT_FLAG_NO_PRICE)) {
+        bool changed = packet.price != currentBTCPrice || packet.change1h != (float)btc1hChange ||
+                       packet.change1d != (float)btc1dChange || packet.change24h != (float)btc24hChange;
+        currentBTCPrice = packet.price;
+        btc1hChange = packet.change1h;
+        btc1dChange = packet.change1d;
+        btc24hChange = packet.change24h;
+        lastPriceUpdate = millis() - packet.ageMs;
+        lastPriceSource = "lan";
+        if (changed) {
+            publishTick(micros());
+        }
+    }
+    xSemaphoreGive(priceMutex);
+}
+
+// Fan-out housekeeping: (re)joins the multicast group with WiFi, sends the leader's
+// snapshots (on each new tick, plus heartbeats), and promotes this device when the
+// leader has been silent, or stuck on a stale price, too long
+void fanoutTask(void *pvParameters) {
+    bool listening = false;
+    
+    while (true) {
+        if (!wifiConnected) {
+            if (listening) {
+                fanoutUdp.close();
+                listening = false;
+            }
+        } else if (!listening) {
+            listening = fanoutUdp.listenMulticast(FANOUT_GROUP, FANOUT_PORT);
+            if (listening) {
+                fanout.listening(millis());
+                fanoutUdp.onPacket(handleFanoutPacket);
+            }
+        } else if (xSemaphoreTake(priceMutex, pdMS_TO_TICKS(50)) == pdTRUE) {
+            if (fanout.role == FANOUT_LEADER) {
+                // New tick, or a heartbeat so followers stay put while the price is unchanged
+                sendSnapshot();
+            } else if (fanout.shouldTakeOver(millis())) {
+                fanout.takeOver(millis());
+                LOG_WARN("Fan-out: leader lost or stale - fetching and broadcasting as %08x", fanout.selfId);
+            }
+            xSemaphoreGive(priceMutex);
+        }
+        
+        // Woken early by broadcastSnapshot() when a fetch publishes a tick
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(FANOUT_HEARTBEAT));
+    }
+}
+
+// Logging Functions
+
+// Formats queued records and fans them out to Serial and the web console. The
+// blocking UART writes and String building happen here instead of in the caller.
+void logTask(void *pvParameters) {
+    LogRecord record;
+    char line[192];
+    
+    while (true) {
+        while (logRing.pop(record)) {
+            // One buffer and one write: Serial.printf mallocs for lines past 64 chars
+            size_t len = formatLogLine(record, line, sizeof(line));
+            appendToConsole(record.timestamp, line + LOG_TAG_BYTES);
+            line[len++] = '\n';
+            Serial.write((const uint8_t*)line, len);
+        }
+        
+        uint32_t dropped = logRing.dropped.exchange(0, std::memory_order_relaxed);
+        if (dropped > 0) {
+            snprintf(line, sizeof(line), "WARNING: %u log messages dropped (queue full)", dropped);
+            Serial.println(line);
+            appendToConsole(millis(), line);
+        }
+        
+        vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_INTERVAL));
+    }
+}
+
+// Record/Replay Functions
+//
+// Record layout is documented in recording.h; scripts/replay_recording.py decodes
+// a downloaded recording on the host.
+
+// Recording is paused while the rings are being downloaded or replayed. The pause
+// expires on its own so an abandoned download can't stop recording for good.
+bool recorderPaused() {
+    return (long)(recorder.pausedUntil - millis()) > 0;
+}
+
+// Append one record to ring, evicting its oldest records to make room. Returns false
+// if the record was dropped (paused, too large, or the rings are busy).
+bool recorderAppend(RecordRing& ring, uint8_t type, unsigned long timestamp, const uint8_t* payload, uint16_t len) {
+    if (xSemaphoreTake(recorderMutex, pdMS_TO_TICKS(10)) != pdTRUE) {
+        return false;
+    }
+    bool stored = !recorderPaused() && ring.append(type, (uint32_t)timestamp, payload, len);
+    xSemaphoreGive(recorderMutex);
+    return stored;
+}
+
+// Record the values a fetch task just published. Caller holds priceMutex.
+void recordTick() {
+    uint8_t payload[REC_TICK_BYTES];
+    packTick(payload, currentBTCPrice, btc1hChange, btc1dChange, btc24hChange);
+    recorderAppend(recorder.ticks, REC_TICK, millis(), payload, REC_TICK_BYTES);
+}
+
+// Record the LED buffer, and what it was rendered from, as a delta against the last
+// stored frame, at most every REC_FRAME_INTERVAL. Keyframes come often enough that the
+// frame ring always holds one (keyframeIntervalFor). The encoder only moves on when
+// the append succeeds, so a frame dropped while paused or contended doesn't break
+// the delta chain.
+void recordFrame(unsigned long timestamp) {
+    static uint8_t previous[NUM_LEDS * 3];
+    static uint8_t scratch[REC_INPUT_BYTES + NUM_LEDS * 3];
+    static FrameEncoder encoder(previous, NUM_LEDS, REC_KEYFRAME_INTERVAL);
+    static unsigned long lastRecorded = 0;
+    
+    if (timestamp - lastRecorded < REC_FRAME_INTERVAL) {
+        return;
+    }
+    const uint8_t* frame = (const uint8_t*)leds;
+    uint8_t type;
+    size_t len = encoder.encode(frame, scratch + REC_INPUT_BYTES, type);
+    if (len == 0) {
+        return;  // Nothing changed
+    }
+    
+    packFrameInputs(scratch, {changeScroll.position, renderSnapshot.price,
+                              renderSnapshot.change1h, renderSnapshot.change1d, renderSnapshot.change24h});
+    if (recorderAppend(recorder.frames, type, timestamp, scratch, REC_INPUT_BYTES + len)) {
+        encoder.committed(frame, type);
+        lastRecorded = timestamp;
+    }
+}
+
+// Chunked-response filler streaming the file header, then the tick ring and the frame
+// ring, each oldest record first
+size_t fillRecordingChunk(uint8_t* buffer, size_t maxLen, size_t index) {
+    const uint8_t fileHeader[REC_FILE_HEADER_BYTES] = {
+        'B', 'T', 'C', 'R', REC_VERSION, (uint8_t)NUM_LEDS, (uint8_t)(NUM_LEDS >> 8), MATRIX_WIDTH, MATRIX_HEIGHT
+    };
+    size_t written = 0;
+    
+    if (index < REC_FILE_HEADER_BYTES) {
+        written = min(REC_FILE_HEADER_BYTES - index, maxLen);
+        memcpy(buffer, fileHeader + index, written);
+        index = 0;
+    } else {
+        index -= REC_FILE_HEADER_BYTES;
+    }
+    
+    // Replay holds the rings for its whole run - try again rather than block the web task
+    if (xSemaphoreTake(recorderMutex, pdMS_TO_TICKS(10)) != pdTRUE) {
+        return written > 0 ? written : RESPONSE_TRY_AGAIN;
+    }
+    
+    // Keep recording paused while chunks are flowing so the rings can't shift under the download
+    recorder.pausedUntil = millis() + REC_PAUSE_TIMEOUT;
+    for (RecordRing* ring : {&recorder.ticks, &recorder.frames}) {
+        if (index >= ring->used) {
+            index -= ring->used;
+            continue;
+        }
+        size_t count = min(ring->used - index, maxLen - written);
+        ring->read(index, buffer + written, count);
+        written += count;
+        index = 0;
+        if (written == maxLen) {
+            break;
+        }
+    }
+    if (written == 0) {
+        recorder.pausedUntil = millis();
+    }
+    xSemaphoreGive(recorderMutex);
+    return written;
+}
+
+// Feed every recorded tick through the ticker renderer as fast as possible, then
+// check every recorded frame against a re-render of its recorded inputs.
+// Runs on the loop task and holds recorderMutex throughout (ticks are in their own ring,
+// so they're all rendered before the frames are checked). Reports per-frame
+// render cost and a checksum of the rendered ticks: the same recording on the same
+// firmware always gives the same checksum, so a changed checksum flags a rendering
+// change. Frames that no longer match what was on the LEDs are counted as differing.
+void runReplay() {
+    if (xSemaphoreTake(recorderMutex, pdMS_TO_TICKS(1000)) != pdTRUE) {
+        LOG_WARN("REPLAY: recorder busy, try again");
+        return;
+    }
+    recorder.pausedUntil = millis() + 60000;
+    PriceSnapshot savedSnapshot = renderSnapshot;
+    ScrollState replayScroll(0, 120);
+    
+    static uint8_t recorded[NUM_LEDS * 3];  // Decoded frame records
+    static uint8_t payload[REC_INPUT_BYTES + NUM_LEDS * 3];
+    uint32_t frames = 0, framesMatched = 0, framesDiffered = 0, framesUndecodable = 0;
+    unsigned long totalMicros = 0, maxMicros = 0;
+    uint32_t checksum = 2166136261UL;
+    bool haveKeyframe = false;
+    
+    fill_solid(leds, NUM_LEDS, CRGB::Black);
+    
+    for (RecordRing* ring : {&recorder.ticks, &recorder.frames}) {
+        for (size_t offset = 0; offset < ring->used; ) {
+            uint8_t header[REC_HEADER_BYTES];
+            ring->read(offset, header, REC_HEADER_BYTES);
+            RecordHeader record = unpackRecordHeader(header);
+            size_t payloadPos = offset + REC_HEADER_BYTES;
+            offset += REC_HEADER_BYTES + record.len;
+            
+            if (record.type == REC_TICK) {
+                double price;
+                float changes[3];
+                ring->read(payloadPos, payload, REC_TICK_BYTES);
+                unpackTick(payload, price, changes);
+                renderSnapshot = {price, changes[0], changes[1], changes[2]};
+                
+                unsigned long start = micros();
+                renderTicker(replayScroll, record.timestamp);
+                matrix->show();
+                unsigned long elapsed = micros() - start;
+                
+                totalMicros += elapsed;
+                maxMicros = max(maxMicros, elapsed);
+                frames++;
+                for (int i = 0; i < NUM_LEDS; i++) {
+                    checksum = (checksum ^ leds[i].r ^ (leds[i].g << 8) ^ (leds[i].b << 16)) * 16777619UL;
+                }
+            } else if (record.len >= REC_INPUT_BYTES && record.len <= sizeof(payload)) {
+                // Frame record: decode it, then redraw the same inputs over the previous
+                // recorded frame (renderTicker only repaints what it owns) and compare
+                ring->read(payloadPos, payload, record.len);
+                memcpy(leds, recorded, sizeof(recorded));
+                if ((record.type == REC_DELTA && !haveKeyframe) ||
+                    !applyFramePixels(record.type, payload + REC_INPUT_BYTES, record.len - REC_INPUT_BYTES, recorded, NUM_LEDS)) {
+                    framesUndecodable++;  // Delta whose keyframe was evicted, or a corrupt record
+                    haveKeyframe = false;  // Wait for the next keyframe to resync
+                    continue;
+                }
+                haveKeyframe = true;
+                
+                FrameInputs inputs = unpackFrameInputs(payload);
+                renderSnapshot = {inputs.price, inputs.change1h, inputs.change1d, inputs.change24h};
+                replayScroll.reset(0);
+                replayScroll.position = inputs.scrollPosition;
+                renderTicker(replayScroll, record.timestamp);
+                
+                if (memcmp(leds, recorded, sizeof(recorded)) == 0) {
+                    framesMatched++;
+                } else {
+                    framesDiffered++;
+                }
+            } else {
+                framesUndecodable++;
+            }
+            esp_task_wdt_reset();
+        }
+    }
+    
+    renderSnapshot = savedSnapshot;
+    recorder.pausedUntil = millis();
+    xSemaphoreGive(recorderMutex);
+    
+    LOG_INFO("REPLAY: %u ticks rendered, avg %lu us, max %lu us, checksum %08x",
+             frames, frames > 0 ? totalMicros / frames : 0UL, maxMicros, checksum);
+    if (framesMatched + framesDiffered + framesUndecodable > 0) {
+        LOG_INFO("REPLAY: %u recorded frames match the render, %u differ, %u undecodable",
+                 framesMatched, framesDiffered, framesUndecodable);
+    }
+}
+
+// Tick-to-Pixel Latency Functions
+
+void recordTickLatency(unsigned long latencyMicros) {
+    int bucket = 0;
+    for (unsigned long ms = latencyMicros / 1000; ms > 0 && bucket < LATENCY_BUCKETS - 1; ms >>= 1) {
+        bucket++;
+    }
+    tickLatency.counts[bucket]++;
+    tickLatency.samples++;
+    tickLatency.maxMicros = max(tickLatency.maxMicros, (uint32_t)latencyMicros);
+    
+    if (latencyMicros > LATENCY_TARGET_MS * 1000UL) {
+        tickLatency.overTarget++;
+        
+        // Rate-limited so a stuck renderer doesn't flood the console
+        static unsigned long lastWarning = 0;
+        if (millis() - lastWarning > 60000) {
+            lastWarning = millis();
+            LOG_WARN("Tick-to-pixel latency %lu ms exceeds %d ms target (%u/%u over)",
+                     latencyMicros / 1000, LATENCY_TARGET_MS, tickLatency.overTarget, tickLatency.samples);
+        }
+    }
+}
+
+// Upper bound (ms) of the histogram bucket containing the given percentile
+unsigned long latencyPercentileMs(int percentile) {
+    if (tickLatency.samples == 0) {
+        return 0;
+    }
+    uint32_t threshold = (tickLatency.samples * percentile + 99) / 100;
+    uint32_t seen = 0;
+    for (int bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+        seen += tickLatency.counts[bucket];
+        if (seen >= threshold) {
+            return 1UL << bucket;
+        }
+    }
+    return 1UL << (LATENCY_BUCKETS - 1);
+}
+
+// Resource Monitoring Functions
+
+// Warn while there is still room to act: TLS handshakes need one large contiguous
+// block, so the largest free block matters more than total free heap
+void checkHeapFragmentation(const ResourceSample& sample) {
+    static bool warned = false;
+    bool low = sample.largestFreeBlock < TLS_MIN_FREE_BLOCK + TLS_MIN_FREE_BLOCK / 2;
+    
+    if (low && !warned) {
+        int fragmentation = 100 - (int)(100ULL * sample.largestFreeBlock / max(sample.freeHeap, (uint32_t)1));
+        LOG_WARN("Largest free block %u bytes (%d%% fragmented) - TLS allocations may soon fail",
+                 sample.largestFreeBlock, fragmentation);
+    } else if (!low && warned) {
+        LOG_INFO("Heap fragmentation recovered - largest free block %u bytes", sample.largestFreeBlock);
+    }
+    warned = low;
+}
+
+// Once warmed up (connections open, newlib's per-task state initialised) the fetch, render
+// and log tasks must not allocate. Warns about each one that does; ALLOC_STRICT aborts.
+void checkSteadyAllocations() {
+#if ALLOC_COUNTING
+    static bool steady = false;
+    static uint32_t lastSeen[MONITORED_TASK_COUNT];
+    if (millis() < ALLOC_WARMUP) {
+        return;
+    }
+    
+    for (int i = 0; i < MONITORED_TASK_COUNT; i++) {
+        MonitoredTask& task = monitoredTasks[i];
+        uint32_t allocations = task.allocations;
+        if (!steady) {
+            task.steadyBaseline = allocations;
+        } else if (task.allocFree && allocations != lastSeen[i]) {
+            LOG_WARN("%s made %u heap allocations in steady state", task.name, allocations - lastSeen[i]);
+#if ALLOC_STRICT
+            Serial.printf("ALLOC_STRICT: %s allocated in steady state - aborting\n", task.name);
+            Serial.flush();
+            abort();
+#endif
+        }
+        lastSeen[i] = allocations;
+    }
+    steady = true;
+#endif
+}
+
+// Steady-state allocations by the fetch/render/log tasks, -1 when not counted
+long steadyAllocations() {
+    long total = ALLOC_COUNTING && millis() >= ALLOC_WARMUP ? 0 : -1;
+    for (int i = 0; total >= 0 && i < MONITORED_TASK_COUNT; i++) {
+        if (monitoredTasks[i].allocFree) {
+            total += monitoredTasks[i].allocations - monitoredTasks[i].steadyBaseline;
+        }
+    }
+    return total;
+}
+
+// Suggested stack size: observed peak usage plus a safety margin, rounded up to 512 bytes
+uint32_t recommendedStackSize(const MonitoredTask& task) {
+    uint32_t peakUsage = task.stackSize - task.minFreeStack;
+    uint32_t recommended = peakUsage + max(peakUsage / 4, (uint32_t)STACK_SAFETY_MARGIN);
+    return (recommended + 511) & ~511UL;
+}
+
+// One line of the heap/stack summary and per-task right-sizing advice, newline included.
+// Returns its length (0 for a skipped line), -1 past the last line, or RESOURCE_LINE_BUSY
+// if resourceMutex stayed taken for waitMs. Generated a line at a time so the report
+// streams to Serial or HTTP without being built in RAM.
+int resourceReportLine(int n, char* out, size_t outLen, uint32_t waitMs) {
+    const int taskLines = 3, reclaimLine = taskLines + MONITORED_TASK_COUNT, sampleLines = reclaimLine + 2;
+    if (n == 0) {
+        return snprintf(out, outLen, "=== RESOURCE REPORT (uptime %lus) ===\n", millis() / 1000);
+    }
+    if (xSemaphoreTake(resourceMutex, pdMS_TO_TICKS(waitMs)) != pdTRUE) {
+        return RESOURCE_LINE_BUSY;
+    }
+    
+    int len = 0;
+    const ResourceSample& latest = resourceHistory[(resourceHistoryHead + RESOURCE_HISTORY - 1) % RESOURCE_HISTORY];
+    if (n == 1 && resourceHistoryCount > 0) {
+        len = snprintf(out, outLen, "Free heap: %u bytes (min %u, max %u, boot low-water %u)\n",
+                       latest.freeHeap, resourceStats.minFreeHeap, resourceStats.maxFreeHeap, ESP.getMinFreeHeap());
+    } else if (n == 2 && resourceHistoryCount > 0) {
+        len = snprintf(out, outLen, "Largest free block: %u bytes (min %u, TLS needs ~%d)\n",
+                       latest.largestFreeBlock, resourceStats.minLargestBlock, TLS_MIN_FREE_BLOCK);
+    } else if (n >= taskLines && n < reclaimLine) {
+        const MonitoredTask& task = monitoredTasks[n - taskLines];
+        if (*task.handle != NULL && task.minFreeStack != UINT32_MAX) {
+            len = snprintf(out, outLen, "%s: stack %u, peak used %u, recommend %u", task.name, task.stackSize,
+                           task.stackSize - task.minFreeStack, recommendedStackSize(task));
+#if ALLOC_COUNTING
+            len += snprintf(out + len, outLen - len, ", %u allocations", task.allocations);
+#endif
+            len += snprintf(out + len, outLen - len, "\n");
+        }
+    } else if (n == reclaimLine) {
+        int32_t reclaimable = 0;
+        for (int i = 0; i < MONITORED_TASK_COUNT; i++) {
+            const MonitoredTask& task = monitoredTasks[i];
+            if (*task.handle != NULL && task.minFreeStack != UINT32_MAX) {
+                reclaimable += (int32_t)task.stackSize - (int32_t)recommendedStackSize(task);
+            }
+        }
+        len = snprintf(out, outLen, "Reclaimable stack: %d bytes\n", reclaimable);
+    } else if (n == reclaimLine + 1) {
+        len = snprintf(out, outLen, "Recent samples (ms: free heap / largest block):\n");
+    } else if (n >= sampleLines && n - sampleLines < resourceHistoryCount) {
+        // Oldest first
+        const ResourceSample& sample = resourceHistory[(resourceHistoryHead + RESOURCE_HISTORY - resourceHistoryCount + n - sampleLines) % RESOURCE_HISTORY];
+        len = snprintf(out, outLen, "  %lu: %u / %u\n", sample.timestamp, sample.freeHeap, sample.largestFreeBlock);
+    } else if (n >= sampleLines) {
+        len = -1;
+    }
+    
+    xSemaphoreGive(resourceMutex);
+    return min(len, (int)outLen - 1);
+}
+
+// Chunked-response filler for /resources: hands out the report line by line, picking
+// up where the previous chunk stopped. While the monitor task holds the data the
+// server is asked to call back rather than the report being cut short.
+size_t fillResourceChunk(ReportCursor& cursor, uint8_t* buffer, size_t maxLen) {
+    size_t written = 0;
+    while (written < maxLen) {
+        if (cursor.offset == cursor.len) {
+            int len = resourceReportLine(cursor.line, cursor.text, sizeof(cursor.text), 10);
+            if (len == RESOURCE_LINE_BUSY) {
+                return written > 0 ? written : RESPONSE_TRY_AGAIN;
+            }
+            if (len < 0) {
+                break;
+            }
+            cursor.line++;
+            cursor.len = len;
+            cursor.offset = 0;
+            continue;
+        }
+        size_t count = min(cursor.len - cursor.offset, maxLen - written);
+        memcpy(buffer + written, cursor.text + cursor.offset, count);
+        written += count;
+        cursor.offset += count;
+    }
+    return written;
+}
+
+// Periodically sample heap and task stack headroom into the history ring
+void resourceMonitorTask(void *pvParameters) {
+    while (true) {
+        ResourceSample sample;
+        sample.timestamp = millis();
+        sample.freeHeap = ESP.getFreeHeap();
+        sample.largestFreeBlock = ESP.getMaxAllocHeap();
+        for (int i = 0; i < MONITORED_TASK_COUNT; i++) {
+            TaskHandle_t handle = *monitoredTasks[i].handle;
+            sample.freeStack[i] = handle != NULL ? uxTaskGetStackHighWaterMark(handle) : 0;
+        }
+        
+        if (xSemaphoreTake(resourceMutex, pdMS_TO_TICKS(100)) == pdTRUE) {
+            resourceHistory[resourceHistoryHead] = sample;
+            resourceHistoryHead = (resourceHistoryHead + 1) % RESOURCE_HISTORY;
+            if (resourceHistoryCount < RESOURCE_HISTORY) {
+                resourceHistoryCount++;
+            }
+            
+            // Track extremes over the whole uptime
+            resourceStats.minFreeHeap = min(resourceStats.minFreeHeap, sample.freeHeap);
+            resourceStats.maxFreeHeap = max(resourceStats.maxFreeHeap, sample.freeHeap);
+            resourceStats.minLargestBlock = min(resourceStats.minLargestBlock, sample.largestFreeBlock);
+            for (int i = 0; i < MONITORED_TASK_COUNT; i++) {
+                if (sample.freeStack[i] > 0) {
+                    monitoredTasks[i].minFreeStack = min(monitoredTasks[i].minFreeStack, sample.freeStack[i]);
+                }
+            }
+            xSemaphoreGive(resourceMutex);
+        }
+        
+        checkHeapFragmentation(sample);
+        checkSteadyAllocations();
+        
+        // Periodic right-sizing summary on the console
+        static unsigned long lastReport = 0;
+        if (millis() - lastReport > RESOURCE_REPORT_INTERVAL) {
+            lastReport = millis();
+            char line[RESOURCE_LINE_BYTES];
+            int len;
+            for (int n = 0; (len = resourceReportLine(n, line, sizeof(line), 100)) >= 0; n++) {
+                Serial.write((const uint8_t*)line, len);
+            }
+            if (len == RESOURCE_LINE_BUSY) {
+                Serial.println("Resource data busy");
+            }
+        }
+        
+        vTaskDelay(pdMS_TO_TICKS(RESOURCE_SAMPLE_INTERVAL));
+    }
+}
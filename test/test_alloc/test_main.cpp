@@ -0,0 +1,279 @@
+// Heap allocations in a steady-state fetch/parse/log cycle, counted by malloc, calloc
+// and realloc wrappers as on the device (ALLOC_COUNTING): recorded HTTP responses
+// (Content-Length, chunked and 304) read by the firmware's response reader into a fixed
+// arena from a fake transport, parsed by the real parsers, logged, broadcast and
+// formatted into LogTask's line buffer. Once warmed up the cycle must not allocate.
+// The socket and TLS layers underneath httpGet aren't covered.
+// Run with: pio test -e native_alloc (it needs the -Wl,--wrap flags of that env)
+
+#include <unity.h>
+#include <stdlib.h>
+#include <new>
+#include "price_parsers.h"
+#include "http_response.h"
+#include "log_ring.h"
+#include "fanout.h"
+
+const size_t PRICE_BODY_BYTES = 2048;  // Per-lane arena, as in the firmware
+const size_t ETAG_BYTES = 72;
+const int WARMUP_CYCLES = 10;
+const int STEADY_CYCLES = 1000;
+
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t count, size_t size);
+void* __real_realloc(void* ptr, size_t size);
+
+// Volatile: GCC assumes malloc leaves globals alone and would cache reads across calls
+volatile unsigned long allocations = 0;
+
+void* __wrap_malloc(size_t size) {
+    allocations++;
+    return __real_malloc(size);
+}
+
+void* __wrap_calloc(size_t count, size_t size) {
+    allocations++;
+    return __real_calloc(count, size);
+}
+
+void* __wrap_realloc(void* ptr, size_t size) {
+    allocations++;
+    return __real_realloc(ptr, size);
+}
+}
+
+// libstdc++'s operator new calls malloc inside the shared library, out of --wrap's
+// reach, so route C++ allocations through the wrapped malloc here
+void* operator new(size_t size) {
+    void* ptr = malloc(size);
+    if (ptr == NULL) {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept {
+    free(ptr);
+}
+
+typedef bool (*PriceParser)(const char* body, size_t len, double& price, double& change24h, double& change1h);
+
+// A recorded response served back a few bytes at a time, as a socket would
+struct FakeTransport {
+    const char* data;
+    size_t len;
+    size_t pos;
+    unsigned long clock;
+    
+    int read() {
+        return pos < len ? (uint8_t)data[pos++] : -1;
+    }
+    
+    int read(uint8_t* buffer, size_t count) {
+        size_t n = count < 64 ? count : 64;
+        n = n < len - pos ? n : len - pos;
+        memcpy(buffer, data + pos, n);
+        pos += n;
+        return (int)n;
+    }
+    
+    bool connected() {
+        return pos < len;
+    }
+    
+    unsigned long now() {
+        return clock++;
+    }
+    
+    void idle() {
+    }
+};
+
+struct RecordedSource {
+    const char* name;
+    PriceParser parse;
+    const char* response;  // Status line, headers and body as received
+};
+
+const RecordedSource SOURCES[] = {
+    {"coingecko", parseCoinGeckoMarkets,
+     "HTTP/1.1 200 OK\r\nContent-Type: application/json; charset=utf-8\r\n"
+     "Cache-Control: public, max-age=30\r\nETag: W/\"7f3c1a9e2b\"\r\nContent-Length: 326\r\n\r\n"
+     "[{\"id\":\"bitcoin\",\"symbol\":\"btc\",\"name\":\"Bitcoin\",\"current_price\":67234,"
+     "\"market_cap\":1327349162466,\"total_volume\":28391734881,\"high_24h\":67980,\"low_24h\":66120,"
+     "\"price_change_24h\":801.12,\"price_change_percentage_24h\":1.20578,\"roi\":null,"
+     "\"last_updated\":\"2024-09-30T12:04:31.512Z\",\"price_change_percentage_1h_in_currency\":-0.15413}]"},
+    {"coinbase", parseCoinbasePrice,
+     "HTTP/1.1 200 OK\r\nContent-Type: application/json; charset=utf-8\r\nCache-Control: public, max-age=1\r\n"
+     "Content-Length: 130\r\n\r\n"
+     "{\"open\":\"66433.09\",\"high\":\"67980.00\",\"low\":\"66120.01\",\"last\":\"67234.51\","
+     "\"volume\":\"7311.48932811\",\"volume_30day\":\"264329.12774410\"}"},
+    {"binance", parseBinancePrice,
+     "HTTP/1.1 200 OK\r\nContent-Type: application/json;charset=UTF-8\r\nTransfer-Encoding: chunked\r\n\r\n"
+     "5d\r\n"
+     "{\"symbol\":\"BTCUSDT\",\"priceChange\":\"803.42000000\",\"priceChangePercent\":\"1.209\","
+     "\"lastPrice\":\"67\r\n"
+     "88\r\n"
+     "234.51000000\",\"openPrice\":\"66431.09000000\",\"volume\":\"18224.38122000\","
+     "\"openTime\":1727611471512,\"closeTime\":1727697871512,\"count\":2247220}\r\n"
+     "0\r\n\r\n"},
+};
+const int SOURCE_COUNT = sizeof(SOURCES) / sizeof(SOURCES[0]);
+
+// CoinGecko answering the If-None-Match of the response above
+const char* NOT_MODIFIED_RESPONSE =
+    "HTTP/1.1 304 Not Modified\r\nCache-Control: public, max-age=30\r\nETag: W/\"7f3c1a9e2b\"\r\n\r\n";
+
+char arena[PRICE_BODY_BYTES];
+char etag[ETAG_BYTES];
+char serialOut[4096];  // Stands in for the UART
+size_t serialUsed = 0;
+LogRing ring;
+FanoutElection follower(true);
+uint32_t sequence = 0;
+
+HttpResponse receive(const char* recorded) {
+    FakeTransport transport = {recorded, strlen(recorded), 0, 0};
+    return readHttpResponse(transport, arena, sizeof(arena), etag, sizeof(etag), 1000000UL);
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// One round: every source fetched and parsed, the winner logged and broadcast, then
+// LogTask's drain. Returns how many sources parsed.
+int cycle(unsigned long now) {
+    int parsed = 0;
+    for (int i = 0; i < SOURCE_COUNT; i++) {
+        HttpResponse response = receive(SOURCES[i].response);
+        double price = 0.0, change24h = 0.0, change1h = NAN;
+        if (response.status != 200 || !SOURCES[i].parse(arena, response.bodyLen, price, change24h, change1h)) {
+            continue;
+        }
+        parsed++;
+        ring.push(3, now, "%s: $%.2f (%+.2f%% 24h) in %lu ms from leader %08x, %s", SOURCES[i].name, price,
+                  change24h, 180UL + i, 0x1234ABCDu, "a line longer than Serial.printf's 64-byte buffer");
+        
+        FanoutPacket sent, received;
+        encodeFanoutPacket(sent, 0x1234ABCD, ++sequence, 120, price, change1h, 0.0f, change24h);
+        TEST_ASSERT_TRUE(decodeFanoutPacket((const uint8_t*)&sent, sizeof(sent), received));
+        follower.onPacket(received, 0, now);
+    }
+    
+    // The next poll of the first source comes back unchanged
+    HttpResponse notModified = receive(NOT_MODIFIED_RESPONSE);
+    TEST_ASSERT_EQUAL_INT(304, notModified.status);
+    
+    LogRecord record;
+    char line[192];
+    while (ring.pop(record)) {
+        size_t len = formatLogLine(record, line, sizeof(line));
+        line[len++] = '\n';
+        if (serialUsed + len > sizeof(serialOut)) {
+            serialUsed = 0;
+        }
+        memcpy(serialOut + serialUsed, line, len);
+        serialUsed += len;
+    }
+    return parsed;
+}
+
+// The steady-state check below means nothing if the wrappers aren't linked in
+void test_wrappers_count_allocations(void) {
+    unsigned long before = allocations;
+    void* volatile block = malloc(32);
+    free(block);
+    int* volatile value = new int(7);
+    delete value;
+    TEST_ASSERT_EQUAL_UINT32(2, allocations - before);
+}
+
+// The recorded responses read back as the firmware's httpGet would see them
+void test_responses_read_into_arena(void) {
+    HttpResponse response = receive(SOURCES[0].response);
+    TEST_ASSERT_EQUAL_INT(200, response.status);
+    TEST_ASSERT_EQUAL_UINT32(326, response.bodyLen);
+    TEST_ASSERT_EQUAL_UINT32(30000, response.maxAge);
+    TEST_ASSERT_EQUAL_STRING("W/\"7f3c1a9e2b\"", etag);
+    TEST_ASSERT_TRUE(response.keepAlive);
+    
+    response = receive(SOURCES[2].response);
+    TEST_ASSERT_EQUAL_INT(200, response.status);
+    TEST_ASSERT_EQUAL_UINT32(0x5d + 0x88, response.bodyLen);
+    TEST_ASSERT_NOT_NULL(strstr(arena, "\"lastPrice\":\"67234.51000000\""));
+    TEST_ASSERT_EQUAL_STRING("", etag);
+    
+    // Truncated, and too large for the arena
+    TEST_ASSERT_EQUAL_INT(-1, receive("HTTP/1.1 200 OK\r\nContent-Length: 50\r\n\r\n{\"last\":").status);
+    TEST_ASSERT_EQUAL_INT(-1, receive("HTTP/1.1 200 OK\r\nContent-Length: 4096\r\n\r\n{}").status);
+}
+
+// OTA resume checks a 206's range against the offset it asked for
+void test_content_range_parsed(void) {
+    size_t first = 0;
+    long total = 0;
+    TEST_ASSERT_TRUE(parseContentRange("bytes 524288-1048575/1048576", first, total));
+    TEST_ASSERT_EQUAL_UINT32(524288, first);
+    TEST_ASSERT_EQUAL_INT32(1048576, total);
+    TEST_ASSERT_TRUE(parseContentRange("bytes 0-99/*", first, total));
+    TEST_ASSERT_EQUAL_UINT32(0, first);
+    TEST_ASSERT_EQUAL_INT32(-1, total);
+    TEST_ASSERT_FALSE(parseContentRange("bytes */1048576", first, total));
+    TEST_ASSERT_FALSE(parseContentRange("items 0-99/100", first, total));
+    TEST_ASSERT_FALSE(parseContentRange("", first, total));
+}
+
+void test_formatted_line_is_one_write(void) {
+    follower.begin(0x00C0FFEE, 3500, 30000);
+    serialUsed = 0;
+    TEST_ASSERT_EQUAL_INT(SOURCE_COUNT, cycle(1000));
+    serialOut[serialUsed] = '\0';
+    TEST_ASSERT_EQUAL_INT(0, strncmp(serialOut, "[I] coingecko: $67234.00 (+1.21% 24h) in 180 ms", 47));
+    TEST_ASSERT_GREATER_THAN(64 * SOURCE_COUNT, serialUsed);
+}
+
+void test_steady_state_cycle_does_not_allocate(void) {
+    unsigned long now = 2000;
+    for (int i = 0; i < WARMUP_CYCLES; i++) {
+        cycle(now += 5000);
+    }
+    
+    unsigned long before = allocations;
+    int parsed = 0;
+    for (int i = 0; i < STEADY_CYCLES; i++) {
+        parsed += cycle(now += 5000);
+    }
+    TEST_ASSERT_EQUAL_INT(SOURCE_COUNT * STEADY_CYCLES, parsed);
+    TEST_ASSERT_EQUAL_UINT32(0, allocations - before);
+    TEST_ASSERT_EQUAL_UINT32(0, ring.dropped.load());
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_wrappers_count_allocations);
+    RUN_TEST(test_responses_read_into_arena);
+    RUN_TEST(test_content_range_parsed);
+    RUN_TEST(test_formatted_line_is_one_write);
+    RUN_TEST(test_steady_state_cycle_does_not_allocate);
+    return UNITY_END();
+}
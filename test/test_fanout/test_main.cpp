@@ -0,0 +1,173 @@
+// LAN fan-out: datagram encode/decode and leader election driven with synthetic
+// packets and times. Run with: pio test -e native -f test_fanout
+
+#include <unity.h>
+#include "fanout.h"
+
+const unsigned long TIMEOUT = 3500;   // FANOUT_LEADER_TIMEOUT
+const unsigned long STALE = 30000;    // FANOUT_STALE_AFTER
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+FanoutPacket packetFrom(uint32_t leaderId, uint32_t sequence, uint32_t ageMs, double price = 60000.0) {
+    FanoutPacket packet;
+    encodeFanoutPacket(packet, leaderId, sequence, ageMs, price, 0.5f, -1.25f, 2.0f);
+    return packet;
+}
+
+FanoutElection follower(uint32_t id, unsigned long now) {
+    FanoutElection election(true);
+    election.begin(id, TIMEOUT, STALE);
+    election.listening(now);
+    return election;
+}
+
+void test_round_trip(void) {
+    TEST_ASSERT_EQUAL_INT(38, sizeof(FanoutPacket));
+    FanoutPacket sent = packetFrom(0x12345678, 7, 1500);
+    FanoutPacket received;
+    TEST_ASSERT_TRUE(decodeFanoutPacket((const uint8_t*)&sent, sizeof(sent), received));
+    TEST_ASSERT_EQUAL_HEX32(0x12345678, received.leaderId);
+    TEST_ASSERT_EQUAL_UINT32(7, received.sequence);
+    TEST_ASSERT_EQUAL_UINT32(1500, received.ageMs);
+    TEST_ASSERT_EQUAL_INT(0, received.flags);
+    TEST_ASSERT_EQUAL_DOUBLE(60000.0, received.price);
+    TEST_ASSERT_EQUAL_FLOAT(-1.25f, received.change1d);
+}
+
+// Wire layout as documented for host decoders: "<4sBBIIIdfff"
+void test_little_endian_layout(void) {
+    FanoutPacket sent = packetFrom(0x01020304, 0x0A0B0C0D, 0);
+    const uint8_t* bytes = (const uint8_t*)&sent;
+    TEST_ASSERT_EQUAL_MEMORY("BTCF", bytes, 4);
+    TEST_ASSERT_EQUAL_INT(FANOUT_VERSION, bytes[4]);
+    TEST_ASSERT_EQUAL_HEX8(0x04, bytes[6]);
+    TEST_ASSERT_EQUAL_HEX8(0x01, bytes[9]);
+    TEST_ASSERT_EQUAL_HEX8(0x0D, bytes[10]);
+}
+
+void test_rejects_foreign_datagrams(void) {
+    FanoutPacket sent = packetFrom(1, 1, 0);
+    FanoutPacket received;
+    TEST_ASSERT_FALSE(decodeFanoutPacket((const uint8_t*)&sent, sizeof(sent) - 1, received));
+    sent.version = 1;
+    TEST_ASSERT_FALSE(decodeFanoutPacket((const uint8_t*)&sent, sizeof(sent), received));
+    sent = packetFrom(1, 1, 0);
+    sent.magic[0] = 'X';
+    TEST_ASSERT_FALSE(decodeFanoutPacket((const uint8_t*)&sent, sizeof(sent), received));
+}
+
+void test_no_price_is_flagged(void) {
+    FanoutPacket sent = packetFrom(1, 1, 800, 0.0);
+    TEST_ASSERT_EQUAL_INT(FANOUT_FLAG_NO_PRICE, sent.flags);
+}
+
+// A leader that hasn't got a price yet still heartbeats, so followers stay put
+void test_no_price_heartbeats_hold_followers(void) {
+    FanoutElection election = follower(500, 0);
+    for (unsigned long now = 1000; now < 20000; now += 1000) {
+        FanoutPacket packet = packetFrom(100, now / 1000, now, 0.0);
+        TEST_ASSERT_NOT_EQUAL(FANOUT_IGNORE, election.onPacket(packet, 0, now));
+        TEST_ASSERT_FALSE(election.shouldTakeOver(now + 999));
+    }
+    TEST_ASSERT_EQUAL_HEX32(100, election.leaderId);
+}
+
+void test_silence_takeover_is_staggered(void) {
+    FanoutElection early = follower(100, 0);
+    FanoutElection late = follower(900, 0);
+    TEST_ASSERT_FALSE(early.shouldTakeOver(TIMEOUT));
+    TEST_ASSERT_TRUE(early.shouldTakeOver(TIMEOUT + 101));
+    TEST_ASSERT_FALSE(late.shouldTakeOver(TIMEOUT + 101));
+    TEST_ASSERT_TRUE(late.shouldTakeOver(TIMEOUT + 901));
+}
+
+// A leader whose fetches all fail keeps heartbeating an ageing price; followers
+// take over once it has been stale for STALE
+void test_stale_leader_replaced(void) {
+    FanoutElection election = follower(500, 0);
+    unsigned long now = 1000;
+    for (; now < 200000; now += 1000) {
+        TEST_ASSERT_NOT_EQUAL(FANOUT_IGNORE, election.onPacket(packetFrom(100, now / 1000, now), 0, now));
+        if (election.shouldTakeOver(now)) {
+            break;
+        }
+    }
+    TEST_ASSERT_GREATER_THAN(2 * STALE, now);
+    TEST_ASSERT_LESS_THAN(2 * STALE + 500 + 2000, now);
+    election.takeOver(now);
+    TEST_ASSERT_EQUAL_INT(FANOUT_LEADER, election.role);
+    TEST_ASSERT_EQUAL_HEX32(500, election.leaderId);
+}
+
+void test_lower_id_wins_between_fresh_leaders(void) {
+    FanoutElection election = follower(500, 0);
+    election.takeOver(5000);
+    TEST_ASSERT_EQUAL(FANOUT_IGNORE, election.onPacket(packetFrom(900, 1, 100), 100, 6000));
+    TEST_ASSERT_EQUAL_INT(FANOUT_LEADER, election.role);
+    TEST_ASSERT_EQUAL(FANOUT_NEW_LEADER, election.onPacket(packetFrom(100, 1, 100), 100, 6000));
+    TEST_ASSERT_EQUAL_INT(FANOUT_FOLLOWER, election.role);
+    TEST_ASSERT_EQUAL_HEX32(100, election.leaderId);
+}
+
+// The stale leader steps down for a new one, even with a lower ID; the new leader
+// is given STALE to fetch before its inherited price counts against it
+void test_fresh_leader_beats_stale_one(void) {
+    FanoutElection old = follower(100, 0);
+    old.takeOver(0);
+    FanoutElection fresh = follower(900, 0);
+    fresh.takeOver(100000);
+    
+    uint32_t staleAge = STALE + 5000;
+    TEST_ASSERT_EQUAL(FANOUT_IGNORE, fresh.onPacket(packetFrom(100, 1, staleAge), staleAge, 100500));
+    TEST_ASSERT_EQUAL_INT(FANOUT_LEADER, fresh.role);
+    TEST_ASSERT_EQUAL(FANOUT_NEW_LEADER, old.onPacket(packetFrom(900, 1, 200), staleAge, 101000));
+    TEST_ASSERT_EQUAL_INT(FANOUT_FOLLOWER, old.role);
+}
+
+// Followers already on a fresh leader ignore a stale rival, but follow its price
+// while it is the only leader they have
+void test_stale_rival_does_not_steal_followers(void) {
+    FanoutElection election = follower(500, 0);
+    TEST_ASSERT_EQUAL(FANOUT_NEW_LEADER, election.onPacket(packetFrom(900, 1, 100), 0, 1000));
+    TEST_ASSERT_EQUAL(FANOUT_IGNORE, election.onPacket(packetFrom(100, 1, STALE + 1), 0, 1500));
+    TEST_ASSERT_EQUAL_HEX32(900, election.leaderId);
+    
+    FanoutElection fresh = follower(500, 0);
+    TEST_ASSERT_EQUAL(FANOUT_NEW_LEADER, fresh.onPacket(packetFrom(100, 1, STALE + 1), 0, 1000));
+}
+
+void test_missed_sequences_counted(void) {
+    FanoutElection election = follower(500, 0);
+    election.onPacket(packetFrom(100, 10, 0), 0, 1000);
+    election.onPacket(packetFrom(100, 11, 0), 0, 2000);
+    election.onPacket(packetFrom(100, 14, 0), 0, 3000);
+    TEST_ASSERT_EQUAL_UINT32(2, election.missed);
+}
+
+void test_own_loopback_ignored(void) {
+    FanoutElection election = follower(500, 0);
+    TEST_ASSERT_EQUAL(FANOUT_IGNORE, election.onPacket(packetFrom(500, 1, 0), 0, 1000));
+    TEST_ASSERT_TRUE(election.shouldTakeOver(TIMEOUT + 501));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip);
+    RUN_TEST(test_little_endian_layout);
+    RUN_TEST(test_rejects_foreign_datagrams);
+    RUN_TEST(test_no_price_is_flagged);
+    RUN_TEST(test_no_price_heartbeats_hold_followers);
+    RUN_TEST(test_silence_takeover_is_staggered);
+    RUN_TEST(test_stale_leader_replaced);
+    RUN_TEST(test_lower_id_wins_between_fresh_leaders);
+    RUN_TEST(test_fresh_leader_beats_stale_one);
+    RUN_TEST(test_stale_rival_does_not_steal_followers);
+    RUN_TEST(test_missed_sequences_counted);
+    RUN_TEST(test_own_loopback_ignored);
+    return UNITY_END();
+}
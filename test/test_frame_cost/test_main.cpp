@@ -0,0 +1,114 @@
+// Host benchmark of per-frame CPU cost against LED count: the sub-pixel strip blend
+// over every row of the wall plus the recorder's frame delta encode, for walls from a
+// single 32x16 panel up to 128x64. Run with: pio test -e native -f test_frame_cost -v
+//
+// Absolute numbers are the host's, not the ESP32's; what carries over is the shape -
+// cost per LED should stay flat as the wall grows. Refresh time on the wire
+// (~30 us per LED per output) is printed alongside for comparison.
+
+#include <unity.h>
+#include <stdio.h>
+#include <chrono>
+#include "scroll_blend.h"
+#include "recording.h"
+
+const int STRIP_HEIGHT = 8;
+const int FRAMES = 200;
+
+struct Pixel {
+    uint8_t r, g, b;
+    Pixel() {}
+    Pixel(uint8_t red, uint8_t green, uint8_t blue) : r(red), g(green), b(blue) {}
+};
+
+double nsPerLed[4];
+int caseCount = 0;
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// Column-major zigzag mapping, like a single FastLED_NeoMatrix panel chain
+template <int Width, int Height>
+void buildIndex(uint16_t (*index)[Width]) {
+    for (int x = 0; x < Width; x++) {
+        for (int y = 0; y < Height; y++) {
+            index[y][x] = x * Height + (x % 2 ? Height - 1 - y : y);
+        }
+    }
+}
+
+template <int Width, int Height>
+void benchmarkWall() {
+    const size_t leds = Width * Height;
+    static uint16_t index[Height][Width];
+    static uint16_t strip[(Width + 1) * STRIP_HEIGHT];
+    static Pixel frame[leds];
+    static uint8_t previous[leds * 3];
+    static uint8_t payload[leds * 3];
+    FrameEncoder encoder(previous, leds, 60);
+    buildIndex<Width, Height>(index);
+    
+    // Text-like strip: 5-pixel glyphs with 1-pixel gaps in two colors
+    for (int row = 0; row < STRIP_HEIGHT; row++) {
+        for (int x = 0; x <= Width; x++) {
+            bool lit = row > 0 && row < 6 && x % 6 != 5 && (x + row) % 3 != 0;
+            strip[row * (Width + 1) + x] = lit ? (x / 12 % 2 ? 0x07E0 : 0xF800) : 0;
+        }
+    }
+    
+    size_t recorded = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int n = 0; n < FRAMES; n++) {
+        float fraction = (n % 16) / 16.0f;
+        for (int top = 0; top < Height; top += STRIP_HEIGHT) {
+            blendScrollStrip<Width, Height>(strip, STRIP_HEIGHT, top, fraction, index, frame);
+        }
+        uint8_t type;
+        recorded += encoder.encode((const uint8_t*)frame, payload, type);
+        encoder.committed((const uint8_t*)frame, type);
+    }
+    double elapsedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    
+    double perFrameUs = elapsedNs / FRAMES / 1000.0;
+    nsPerLed[caseCount++] = elapsedNs / FRAMES / leds;
+    printf("%3dx%-3d %5u LEDs: %8.1f us/frame, %5.2f ns/LED, %6.1f kB recorded; wire time %6.1f ms (1 output), %5.1f ms (4)\n",
+           Width, Height, (unsigned)leds, perFrameUs, nsPerLed[caseCount - 1], recorded / 1024.0,
+           leds * 0.03, leds * 0.03 / 4);
+    TEST_ASSERT_GREATER_THAN(0, recorded);
+}
+
+void test_frame_cost_32x16(void) {
+    benchmarkWall<32, 16>();
+}
+
+void test_frame_cost_64x32(void) {
+    benchmarkWall<64, 32>();
+}
+
+void test_frame_cost_128x32(void) {
+    benchmarkWall<128, 32>();
+}
+
+void test_frame_cost_128x64(void) {
+    benchmarkWall<128, 64>();
+}
+
+// Per-LED cost must not grow with the wall. Measured from 64x32 up: a single panel
+// fits in L1 and is cheaper per LED on the host. Generous bound - this is a timing test.
+void test_cost_scales_linearly(void) {
+    TEST_ASSERT_EQUAL_INT(4, caseCount);
+    TEST_ASSERT_LESS_THAN(nsPerLed[1] * 3, nsPerLed[3]);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_frame_cost_32x16);
+    RUN_TEST(test_frame_cost_64x32);
+    RUN_TEST(test_frame_cost_128x32);
+    RUN_TEST(test_frame_cost_128x64);
+    RUN_TEST(test_cost_scales_linearly);
+    return UNITY_END();
+}
@@ -0,0 +1,126 @@
+// Deferred logging: argument packing, the ring, record formatting, and a host
+// benchmark of the call-site cost (push) against the LogTask cost (format).
+// Run with: pio test -e native -f test_log -v
+//
+// Absolute numbers are the host's, not the ESP32's; what carries over is the ratio -
+// a LOG_* call site should cost a small fraction of formatting the line.
+
+#include <unity.h>
+#include <stdio.h>
+#include <chrono>
+#include "log_ring.h"
+
+const int ROUNDS = 100000;
+
+LogRing ring;
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+    LogRecord record;
+    while (ring.pop(record)) {
+    }
+    ring.dropped.store(0);
+}
+
+void formatOne(char* line, size_t len) {
+    LogRecord record;
+    TEST_ASSERT_TRUE(ring.pop(record));
+    formatLogRecord(record, line, len);
+}
+
+void test_formats_integers_reals_and_text(void) {
+    char line[192];
+    char source[16] = "coinbase";
+    ring.push(3, 1234, "%s won in %lu ms, price %.2f, 1h %+.1f%%", source, 212UL, 60123.456, -0.25);
+    source[0] = 'X';  // Stack buffers are copied at the call site
+    formatOne(line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("coinbase won in 212 ms, price 60123.46, 1h -0.2%", line);
+}
+
+// Hex IDs go straight to %08x as integers, no snprintf into a stack string first
+void test_formats_hex_ids(void) {
+    char line[192];
+    uint32_t id = 0x0BADF00D;
+    ring.push(2, 0, "following leader %08x, checksum %08x", id, 0xFFFFFFFFu);
+    formatOne(line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("following leader 0badf00d, checksum ffffffff", line);
+}
+
+void test_missing_args_and_truncation(void) {
+    char line[16];
+    ring.push(3, 0, "a=%d b=%d", 1);
+    formatOne(line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("a=1 b=?", line);
+    
+    ring.push(3, 0, "%s and more text", "a long argument string");
+    formatOne(line, sizeof(line));
+    TEST_ASSERT_EQUAL_STRING("a long argument", line);
+}
+
+void test_text_space_is_bounded(void) {
+    char line[256];
+    char big[100];
+    memset(big, 'x', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+    ring.push(3, 0, "[%s][%s]", big, "tail");
+    formatOne(line, sizeof(line));
+    TEST_ASSERT_EQUAL_INT(LOG_TEXT_BYTES - 1 + 4, strlen(line));
+}
+
+void test_full_ring_drops_and_counts(void) {
+    for (int i = 0; i < LOG_QUEUE_SIZE; i++) {
+        TEST_ASSERT_TRUE(ring.push(3, i, "n=%d", i));
+    }
+    TEST_ASSERT_FALSE(ring.push(3, 0, "dropped"));
+    TEST_ASSERT_EQUAL_UINT32(1, ring.dropped.load());
+    
+    LogRecord record;
+    for (int i = 0; i < LOG_QUEUE_SIZE; i++) {
+        TEST_ASSERT_TRUE(ring.pop(record));
+        TEST_ASSERT_EQUAL_UINT32(i, record.timestamp);
+    }
+    TEST_ASSERT_FALSE(ring.pop(record));
+}
+
+// A typical fetch-path line: push and pop in pairs so the ring never fills
+void test_benchmark_push_vs_format(void) {
+    LogRecord record;
+    char line[192];
+    double pushNs = 0;
+    double formatNs = 0;
+    size_t total = 0;
+    
+    for (int i = 0; i < ROUNDS; i++) {
+        auto start = std::chrono::steady_clock::now();
+        ring.push(3, i, "%s: $%.2f in %lu ms (leader %08x, seq %u)", "coinbase", 60000.0 + i, 180UL + i % 50,
+                  0x1234ABCDu, (unsigned)i);
+        auto pushed = std::chrono::steady_clock::now();
+        ring.pop(record);
+        auto popped = std::chrono::steady_clock::now();
+        formatLogRecord(record, line, sizeof(line));
+        auto formatted = std::chrono::steady_clock::now();
+        
+        pushNs += std::chrono::duration<double, std::nano>(pushed - start).count();
+        formatNs += std::chrono::duration<double, std::nano>(formatted - popped).count();
+        total += strlen(line);
+    }
+    pushNs /= ROUNDS;
+    formatNs /= ROUNDS;
+    printf("logDeferred push: %6.1f ns/call, formatLogRecord: %7.1f ns/line (%.0f chars), record %u bytes\n",
+           pushNs, formatNs, (double)total / ROUNDS, (unsigned)sizeof(LogRecord));
+    TEST_ASSERT_EQUAL_INT(0, ring.dropped.load());
+    TEST_ASSERT_LESS_THAN(formatNs, pushNs);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_formats_integers_reals_and_text);
+    RUN_TEST(test_formats_hex_ids);
+    RUN_TEST(test_missing_args_and_truncation);
+    RUN_TEST(test_text_space_is_bounded);
+    RUN_TEST(test_full_ring_drops_and_counts);
+    RUN_TEST(test_benchmark_push_vs_format);
+    return UNITY_END();
+}
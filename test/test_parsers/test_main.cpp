@@ -0,0 +1,195 @@
+// Price source adapters against recorded response bodies: CoinGecko /coins/markets
+// and /simple/price, Coinbase Exchange stats and Binance 24h ticker, plus missing
+// fields, a null 1h change and a zero 24h change. Run with: pio test -e native -f test_parsers
+
+#include <unity.h>
+#include <math.h>
+#include "price_parsers.h"
+
+const size_t PRICE_BODY_BYTES = 2048;  // Per-lane arena, as in the firmware
+
+typedef bool (*PriceParser)(const char* body, size_t len, double& price, double& change24h, double& change1h);
+
+// Recorded /coins/markets?vs_currency=usd&ids=bitcoin&price_change_percentage=1h
+const char* MARKETS_BODY =
+    "[{\"id\":\"bitcoin\",\"symbol\":\"btc\",\"name\":\"Bitcoin\","
+    "\"image\":\"https://coin-images.coingecko.com/coins/images/1/large/bitcoin.png?1696501400\","
+    "\"current_price\":67234,\"market_cap\":1327349162466,\"market_cap_rank\":1,"
+    "\"fully_diluted_valuation\":1411859785344,\"total_volume\":28391734881,\"high_24h\":67980,"
+    "\"low_24h\":66120,\"price_change_24h\":801.12,\"price_change_percentage_24h\":1.20578,"
+    "\"market_cap_change_24h\":15742918451,\"market_cap_change_percentage_24h\":1.20024,"
+    "\"circulating_supply\":19742981.0,\"total_supply\":21000000.0,\"max_supply\":21000000.0,"
+    "\"ath\":73738,\"ath_change_percentage\":-8.82061,\"ath_date\":\"2024-03-14T07:10:36.635Z\","
+    "\"atl\":67.81,\"atl_change_percentage\":99048.91,\"atl_date\":\"2013-07-06T00:00:00.000Z\","
+    "\"roi\":null,\"last_updated\":\"2024-09-30T12:04:31.512Z\","
+    "\"price_change_percentage_1h_in_currency\":-0.15413}]";
+
+// Same, while CoinGecko hadn't computed the hourly change yet
+const char* MARKETS_NULL_1H_BODY =
+    "[{\"id\":\"bitcoin\",\"symbol\":\"btc\",\"name\":\"Bitcoin\",\"current_price\":67234.5,"
+    "\"price_change_percentage_24h\":1.20578,\"roi\":null,"
+    "\"last_updated\":\"2024-09-30T12:04:31.512Z\",\"price_change_percentage_1h_in_currency\":null}]";
+
+const char* MARKETS_ZERO_24H_BODY =
+    "[{\"id\":\"bitcoin\",\"current_price\":67234,\"price_change_percentage_24h\":0,"
+    "\"price_change_percentage_1h_in_currency\":0.0}]";
+
+const char* MARKETS_NO_PRICE_BODY =
+    "[{\"id\":\"bitcoin\",\"price_change_percentage_24h\":1.2,\"price_change_percentage_1h_in_currency\":0.1}]";
+
+// Recorded /simple/price?ids=bitcoin&vs_currencies=usd&include_24hr_change=true
+const char* SIMPLE_BODY = "{\"bitcoin\":{\"usd\":67234,\"usd_24h_change\":1.2057812993837263}}";
+const char* SIMPLE_ZERO_24H_BODY = "{\"bitcoin\":{\"usd\":67234,\"usd_24h_change\":0}}";
+const char* SIMPLE_NO_CHANGE_BODY = "{\"bitcoin\":{\"usd\":67234}}";
+
+// CoinGecko's rate-limit answer, which comes back with a JSON body too
+const char* RATE_LIMITED_BODY =
+    "{\"status\":{\"error_code\":429,\"error_message\":\"You've exceeded the Rate Limit. Please visit "
+    "https://www.coingecko.com/en/api/pricing to subscribe to our API plans for higher rate limits.\"}}";
+
+// Recorded api.exchange.coinbase.com/products/BTC-USD/stats
+const char* COINBASE_BODY =
+    "{\"open\":\"66433.09\",\"high\":\"67980.00\",\"low\":\"66120.01\",\"last\":\"67234.51\","
+    "\"volume\":\"7311.48932811\",\"volume_30day\":\"264329.12774410\","
+    "\"rfq_volume_24hour\":\"12.554017\",\"rfq_volume_30day\":\"449.911281\"}";
+const char* COINBASE_FLAT_BODY = "{\"open\":\"67234.51\",\"last\":\"67234.51\",\"volume\":\"7311.4\"}";
+const char* COINBASE_NO_OPEN_BODY = "{\"last\":\"67234.51\",\"volume\":\"7311.4\"}";
+
+// Recorded api.binance.com/api/v3/ticker/24hr?symbol=BTCUSDT
+const char* BINANCE_BODY =
+    "{\"symbol\":\"BTCUSDT\",\"priceChange\":\"803.42000000\",\"priceChangePercent\":\"1.209\","
+    "\"weightedAvgPrice\":\"67012.93157238\",\"prevClosePrice\":\"66431.09000000\","
+    "\"lastPrice\":\"67234.51000000\",\"lastQty\":\"0.00129000\",\"bidPrice\":\"67234.50000000\","
+    "\"bidQty\":\"3.41268000\",\"askPrice\":\"67234.51000000\",\"askQty\":\"1.09817000\","
+    "\"openPrice\":\"66431.09000000\",\"highPrice\":\"67980.00000000\",\"lowPrice\":\"66120.00000000\","
+    "\"volume\":\"18224.38122000\",\"quoteVolume\":\"1221260012.35981870\",\"openTime\":1727611471512,"
+    "\"closeTime\":1727697871512,\"firstId\":3812045162,\"lastId\":3814292381,\"count\":2247220}";
+const char* BINANCE_ZERO_24H_BODY = "{\"symbol\":\"BTCUSDT\",\"priceChangePercent\":\"0.000\",\"lastPrice\":\"67234.51000000\"}";
+const char* BINANCE_NO_CHANGE_BODY = "{\"symbol\":\"BTCUSDT\",\"lastPrice\":\"67234.51000000\"}";
+
+double price;
+double change24h;
+double change1h;
+
+void setUp(void) {
+    price = 0.0;
+    change24h = 0.0;
+    change1h = NAN;  // As the price lane starts each result
+}
+
+void tearDown(void) {
+}
+
+bool parse(PriceParser parser, const char* body) {
+    return parser(body, strlen(body), price, change24h, change1h);
+}
+
+void test_markets(void) {
+    TEST_ASSERT_TRUE(parse(parseCoinGeckoMarkets, MARKETS_BODY));
+    TEST_ASSERT_EQUAL_DOUBLE(67234.0, price);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 1.20578, change24h);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, -0.15413, change1h);
+}
+
+// A null 1h change leaves change1h unset (NAN), so the OHLC reference isn't touched
+void test_markets_null_1h_change(void) {
+    TEST_ASSERT_TRUE(parse(parseCoinGeckoMarkets, MARKETS_NULL_1H_BODY));
+    TEST_ASSERT_EQUAL_DOUBLE(67234.5, price);
+    TEST_ASSERT_DOUBLE_IS_NAN(change1h);
+}
+
+void test_markets_zero_24h_change(void) {
+    TEST_ASSERT_TRUE(parse(parseCoinGeckoMarkets, MARKETS_ZERO_24H_BODY));
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, change24h);
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, change1h);
+}
+
+void test_markets_missing_fields(void) {
+    TEST_ASSERT_FALSE(parse(parseCoinGeckoMarkets, MARKETS_NO_PRICE_BODY));
+    TEST_ASSERT_FALSE(parse(parseCoinGeckoMarkets, "[]"));
+    TEST_ASSERT_FALSE(parse(parseCoinGeckoMarkets, RATE_LIMITED_BODY));
+    TEST_ASSERT_FALSE(parse(parseCoinGeckoMarkets, "[{\"id\":\"bitcoin\",\"current_price\":672"));
+}
+
+void test_simple_price(void) {
+    TEST_ASSERT_TRUE(parse(parseCoinGeckoPrice, SIMPLE_BODY));
+    TEST_ASSERT_EQUAL_DOUBLE(67234.0, price);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 1.2057812993837263, change24h);
+    TEST_ASSERT_DOUBLE_IS_NAN(change1h);
+}
+
+void test_simple_price_zero_24h_change(void) {
+    change24h = 5.0;
+    TEST_ASSERT_TRUE(parse(parseCoinGeckoPrice, SIMPLE_ZERO_24H_BODY));
+    TEST_ASSERT_EQUAL_DOUBLE(67234.0, price);
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, change24h);
+}
+
+void test_simple_price_missing_fields(void) {
+    TEST_ASSERT_FALSE(parse(parseCoinGeckoPrice, SIMPLE_NO_CHANGE_BODY));
+    TEST_ASSERT_FALSE(parse(parseCoinGeckoPrice, "{}"));
+    TEST_ASSERT_FALSE(parse(parseCoinGeckoPrice, RATE_LIMITED_BODY));
+}
+
+void test_coinbase(void) {
+    TEST_ASSERT_TRUE(parse(parseCoinbasePrice, COINBASE_BODY));
+    TEST_ASSERT_EQUAL_DOUBLE(67234.51, price);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-6, (67234.51 - 66433.09) / 66433.09 * 100.0, change24h);
+    TEST_ASSERT_DOUBLE_IS_NAN(change1h);
+}
+
+void test_coinbase_zero_24h_change(void) {
+    TEST_ASSERT_TRUE(parse(parseCoinbasePrice, COINBASE_FLAT_BODY));
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, change24h);
+}
+
+void test_coinbase_missing_fields(void) {
+    TEST_ASSERT_FALSE(parse(parseCoinbasePrice, COINBASE_NO_OPEN_BODY));
+    TEST_ASSERT_FALSE(parse(parseCoinbasePrice, "{\"message\":\"NotFound\"}"));
+    TEST_ASSERT_FALSE(parse(parseCoinbasePrice, "<html>502 Bad Gateway</html>"));
+}
+
+void test_binance(void) {
+    TEST_ASSERT_TRUE(parse(parseBinancePrice, BINANCE_BODY));
+    TEST_ASSERT_EQUAL_DOUBLE(67234.51, price);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9, 1.209, change24h);
+    TEST_ASSERT_DOUBLE_IS_NAN(change1h);
+}
+
+void test_binance_zero_24h_change(void) {
+    change24h = 5.0;
+    TEST_ASSERT_TRUE(parse(parseBinancePrice, BINANCE_ZERO_24H_BODY));
+    TEST_ASSERT_EQUAL_DOUBLE(0.0, change24h);
+}
+
+void test_binance_missing_fields(void) {
+    TEST_ASSERT_FALSE(parse(parseBinancePrice, BINANCE_NO_CHANGE_BODY));
+    TEST_ASSERT_FALSE(parse(parseBinancePrice, "{\"code\":-1121,\"msg\":\"Invalid symbol.\"}"));
+}
+
+// The arena is sized from these bodies: the largest, /coins/markets, with room to grow
+void test_bodies_fit_lane_arena(void) {
+    TEST_ASSERT_EQUAL_UINT32(801, strlen(MARKETS_BODY));
+    TEST_ASSERT_EQUAL_UINT32(556, strlen(BINANCE_BODY));
+    TEST_ASSERT_EQUAL_UINT32(194, strlen(COINBASE_BODY));
+    TEST_ASSERT_LESS_THAN(PRICE_BODY_BYTES / 2, strlen(MARKETS_BODY));
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_markets);
+    RUN_TEST(test_markets_null_1h_change);
+    RUN_TEST(test_markets_zero_24h_change);
+    RUN_TEST(test_markets_missing_fields);
+    RUN_TEST(test_simple_price);
+    RUN_TEST(test_simple_price_zero_24h_change);
+    RUN_TEST(test_simple_price_missing_fields);
+    RUN_TEST(test_coinbase);
+    RUN_TEST(test_coinbase_zero_24h_change);
+    RUN_TEST(test_coinbase_missing_fields);
+    RUN_TEST(test_binance);
+    RUN_TEST(test_binance_zero_24h_change);
+    RUN_TEST(test_binance_missing_fields);
+    RUN_TEST(test_bodies_fit_lane_arena);
+    return UNITY_END();
+}
@@ -0,0 +1,86 @@
+// Price source ranking: score order, busy sources, and simulated rounds where the
+// source's own nextFetch trails the round timer. Run with: pio test -e native -f test_ranking
+
+#include <unity.h>
+#include "source_ranking.h"
+
+const unsigned long ROUND_MS = 5000;       // UPDATE_INTERVAL
+const unsigned long TOLERANCE = ROUND_MS / 2;
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_ranks_by_score_ties_in_config_order(void) {
+    SourceCandidate sources[3] = {{300, 0, false}, {120, 0, false}, {120, 0, false}};
+    int ranked[3];
+    TEST_ASSERT_EQUAL_INT(3, rankSources(sources, TOLERANCE, ranked));
+    TEST_ASSERT_EQUAL_INT(1, ranked[0]);
+    TEST_ASSERT_EQUAL_INT(2, ranked[1]);
+    TEST_ASSERT_EQUAL_INT(0, ranked[2]);
+}
+
+void test_busy_sources_skipped(void) {
+    SourceCandidate sources[3] = {{100, 0, true}, {200, 0, false}, {300, 0, true}};
+    int ranked[3];
+    TEST_ASSERT_EQUAL_INT(1, rankSources(sources, TOLERANCE, ranked));
+    TEST_ASSERT_EQUAL_INT(1, ranked[0]);
+}
+
+// nextFetch a few ms after the round start (dispatch skew) still leads the round
+void test_skewed_top_source_still_first(void) {
+    SourceCandidate sources[3] = {{100, 40, false}, {200, 0, false}, {300, 0, false}};
+    int ranked[3];
+    TEST_ASSERT_EQUAL_INT(3, rankSources(sources, TOLERANCE, ranked));
+    TEST_ASSERT_EQUAL_INT(0, ranked[0]);
+}
+
+// A long server max-age demotes the source to a fallback instead of dropping it
+void test_max_age_source_ranks_last(void) {
+    SourceCandidate sources[3] = {{100, 25000, false}, {200, 0, false}, {300, 0, false}};
+    int ranked[3];
+    TEST_ASSERT_EQUAL_INT(3, rankSources(sources, TOLERANCE, ranked));
+    TEST_ASSERT_EQUAL_INT(1, ranked[0]);
+    TEST_ASSERT_EQUAL_INT(2, ranked[1]);
+    TEST_ASSERT_EQUAL_INT(0, ranked[2]);
+}
+
+// Rounds every ROUND_MS; the winning source's nextFetch is set from its dispatch time,
+// which trails the round start by 1-60 ms (or a hedge delay). The best source has to
+// lead every round, not every other one.
+void test_top_source_leads_every_round(void) {
+    const float scores[3] = {150, 400, 600};
+    unsigned long nextFetch[3] = {0, 0, 0};
+    int primaryRounds[3] = {0, 0, 0};
+    
+    for (int round = 0; round < 200; round++) {
+        unsigned long roundStart = 1000 + round * ROUND_MS;
+        SourceCandidate sources[3];
+        for (int i = 0; i < 3; i++) {
+            long remaining = (long)(nextFetch[i] - roundStart);
+            sources[i] = {scores[i], remaining > 0 ? (unsigned long)remaining : 0, false};
+        }
+        int ranked[3];
+        TEST_ASSERT_EQUAL_INT(3, rankSources(sources, TOLERANCE, ranked));
+        primaryRounds[ranked[0]]++;
+        
+        unsigned long dispatchSkew = 1 + round * 7 % 60;
+        nextFetch[ranked[0]] = roundStart + dispatchSkew + ROUND_MS;
+        if (round % 10 == 0) {
+            nextFetch[ranked[1]] = roundStart + 900 + ROUND_MS;  // Hedged after the primary's p90
+        }
+    }
+    TEST_ASSERT_EQUAL_INT(200, primaryRounds[0]);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_ranks_by_score_ties_in_config_order);
+    RUN_TEST(test_busy_sources_skipped);
+    RUN_TEST(test_skewed_top_source_still_first);
+    RUN_TEST(test_max_age_source_ranks_last);
+    RUN_TEST(test_top_source_leads_every_round);
+    return UNITY_END();
+}
@@ -0,0 +1,277 @@
+// Recording format: header/tick/input codecs, the frame encoder/decoder round trip
+// including records the recorder drops, and the record ring - filled in the firmware's
+// default frame ring config, its tail must still decode. Run with: pio test -e native -f test_recording
+
+#include <unity.h>
+#include <stdlib.h>
+#include "recording.h"
+
+const size_t LEDS = MATRIX_WIDTH * MATRIX_HEIGHT;
+const uint16_t KEYFRAME_INTERVAL = 10;
+const size_t FRAME_RING_BYTES = 16384;  // REC_FRAME_BYTES default
+
+uint8_t previous[LEDS * 3];
+uint8_t frame[LEDS * 3];
+uint8_t decoded[LEDS * 3];
+uint8_t payload[LEDS * 3];
+uint8_t record[REC_INPUT_BYTES + LEDS * 3];
+uint8_t ringStorage[FRAME_RING_BYTES];
+
+void setUp(void) {
+    memset(previous, 0, sizeof(previous));
+    memset(frame, 0, sizeof(frame));
+    memset(decoded, 0, sizeof(decoded));
+    srand(1);
+}
+
+void tearDown(void) {
+}
+
+// A little scrolling-ticker-like motion: a band of pixels that moves one LED per frame
+void drawFrame(int n) {
+    memset(frame, 0, sizeof(frame));
+    for (int i = 0; i < 40; i++) {
+        size_t led = (n + i) % LEDS;
+        frame[led * 3] = (uint8_t)(n * 7 + i);
+        frame[led * 3 + 1] = 255;
+    }
+}
+
+// Worst case for the ring: most LEDs change every frame, in runs, so each delta is
+// nearly as large as a keyframe
+void drawNoisyFrame(void) {
+    for (size_t led = 0; led < LEDS; led++) {
+        if (rand() % 8 != 0) {
+            frame[led * 3] = (uint8_t)rand();
+        }
+    }
+}
+
+// Encode the current frame into ring the way recordFrame does. Returns false if
+// nothing changed.
+bool recordInto(RecordRing& ring, FrameEncoder& encoder, uint32_t timestamp) {
+    uint8_t type;
+    size_t len = encoder.encode(frame, record + REC_INPUT_BYTES, type);
+    if (len == 0) {
+        return false;
+    }
+    packFrameInputs(record, {(float)timestamp, 67000.0, 0.0, 0.0, 0.0});
+    TEST_ASSERT_TRUE(ring.append(type, timestamp, record, REC_INPUT_BYTES + len));
+    encoder.committed(frame, type);
+    return true;
+}
+
+// Decode the ring oldest first, as runReplay and replay_recording.py do: deltas ahead
+// of the first keyframe are skipped. Returns the number of frames decoded.
+int decodeRing(const RecordRing& ring, uint32_t& lastTimestamp) {
+    int decodedFrames = 0;
+    bool haveKeyframe = false;
+    for (size_t offset = 0; offset < ring.used; ) {
+        uint8_t bytes[REC_HEADER_BYTES];
+        ring.read(offset, bytes, REC_HEADER_BYTES);
+        RecordHeader header = unpackRecordHeader(bytes);
+        TEST_ASSERT_LESS_OR_EQUAL(sizeof(record), header.len);
+        ring.read(offset + REC_HEADER_BYTES, record, header.len);
+        offset += REC_HEADER_BYTES + header.len;
+        
+        if (header.type == REC_DELTA && !haveKeyframe) {
+            continue;
+        }
+        TEST_ASSERT_TRUE(applyFramePixels(header.type, record + REC_INPUT_BYTES, header.len - REC_INPUT_BYTES,
+                                          decoded, LEDS));
+        haveKeyframe = true;
+        decodedFrames++;
+        lastTimestamp = header.timestamp;
+    }
+    return decodedFrames;
+}
+
+void test_record_header_round_trip(void) {
+    uint8_t bytes[REC_HEADER_BYTES];
+    packRecordHeader(bytes, {REC_DELTA, 1234, 0xdeadbeef});
+    RecordHeader header = unpackRecordHeader(bytes);
+    TEST_ASSERT_EQUAL_UINT8(REC_DELTA, header.type);
+    TEST_ASSERT_EQUAL_UINT16(1234, header.len);
+    TEST_ASSERT_EQUAL_HEX32(0xdeadbeef, header.timestamp);
+}
+
+void test_tick_and_inputs_round_trip(void) {
+    uint8_t bytes[REC_INPUT_BYTES];
+    double price;
+    float changes[3];
+    packTick(bytes, 67123.45, -0.5, 1.25, 3.0);
+    unpackTick(bytes, price, changes);
+    TEST_ASSERT_EQUAL_DOUBLE(67123.45, price);
+    TEST_ASSERT_EQUAL_FLOAT(-0.5f, changes[0]);
+    TEST_ASSERT_EQUAL_FLOAT(1.25f, changes[1]);
+    TEST_ASSERT_EQUAL_FLOAT(3.0f, changes[2]);
+    
+    packFrameInputs(bytes, {-12.75f, 67123.45, -0.5, 1.25, 3.0});
+    FrameInputs inputs = unpackFrameInputs(bytes);
+    TEST_ASSERT_EQUAL_FLOAT(-12.75f, inputs.scrollPosition);
+    TEST_ASSERT_EQUAL_DOUBLE(67123.45, inputs.price);
+    TEST_ASSERT_EQUAL_DOUBLE(3.0, inputs.change24h);
+}
+
+void test_first_frame_is_keyframe_then_deltas(void) {
+    FrameEncoder encoder(previous, LEDS, KEYFRAME_INTERVAL);
+    uint8_t type;
+    
+    drawFrame(0);
+    TEST_ASSERT_EQUAL_UINT32(LEDS * 3, encoder.encode(frame, payload, type));
+    TEST_ASSERT_EQUAL_UINT8(REC_KEYFRAME, type);
+    encoder.committed(frame, type);
+    
+    drawFrame(1);
+    size_t len = encoder.encode(frame, payload, type);
+    TEST_ASSERT_EQUAL_UINT8(REC_DELTA, type);
+    TEST_ASSERT_LESS_THAN(LEDS * 3, len);
+    encoder.committed(frame, type);
+    
+    // Unchanged frame encodes to nothing
+    TEST_ASSERT_EQUAL_UINT32(0, encoder.encode(frame, payload, type));
+}
+
+// Every stored record decodes back to exactly the frame that was encoded, even when
+// a third of the appends are dropped (paused recorder, contended mutex)
+void test_round_trip_with_dropped_appends(void) {
+    FrameEncoder encoder(previous, LEDS, KEYFRAME_INTERVAL);
+    int stored = 0, dropped = 0;
+    
+    for (int n = 0; n < 300; n++) {
+        drawFrame(n);
+        uint8_t type;
+        size_t len = encoder.encode(frame, payload, type);
+        if (len == 0) {
+            continue;
+        }
+        if (rand() % 3 == 0) {
+            dropped++;  // Recorder refused the record - encoder must not move on
+            continue;
+        }
+        TEST_ASSERT_TRUE(applyFramePixels(type, payload, len, decoded, LEDS));
+        TEST_ASSERT_EQUAL_MEMORY(frame, decoded, sizeof(frame));
+        encoder.committed(frame, type);
+        stored++;
+    }
+    
+    TEST_ASSERT_GREATER_THAN(0, dropped);
+    TEST_ASSERT_GREATER_THAN(0, stored);
+}
+
+void test_keyframe_interval_counts_stored_frames(void) {
+    FrameEncoder encoder(previous, LEDS, KEYFRAME_INTERVAL);
+    int keyframes = 0;
+    
+    for (int n = 0; n < 10 * (KEYFRAME_INTERVAL + 1); n++) {
+        drawFrame(n);
+        uint8_t type;
+        encoder.encode(frame, payload, type);
+        encoder.committed(frame, type);
+        keyframes += type == REC_KEYFRAME;
+    }
+    TEST_ASSERT_EQUAL_INT(10, keyframes);
+}
+
+void test_large_change_falls_back_to_keyframe(void) {
+    FrameEncoder encoder(previous, LEDS, KEYFRAME_INTERVAL);
+    uint8_t type;
+    encoder.committed(frame, REC_KEYFRAME);
+    
+    // Every other LED changes: runs of one cost as much as a full frame
+    for (size_t i = 0; i < LEDS; i += 2) {
+        frame[i * 3 + 2] = 9;
+    }
+    TEST_ASSERT_EQUAL_UINT32(LEDS * 3, encoder.encode(frame, payload, type));
+    TEST_ASSERT_EQUAL_UINT8(REC_KEYFRAME, type);
+}
+
+void test_malformed_records_rejected(void) {
+    uint8_t run[6] = {0xff, 0xff, 1, 1, 2, 3};  // Starts past the last LED
+    TEST_ASSERT_FALSE(applyFramePixels(REC_DELTA, run, sizeof(run), decoded, LEDS));
+    TEST_ASSERT_FALSE(applyFramePixels(REC_DELTA, run, 2, decoded, LEDS));
+    TEST_ASSERT_FALSE(applyFramePixels(REC_KEYFRAME, payload, LEDS, decoded, LEDS));
+    TEST_ASSERT_FALSE(applyFramePixels(REC_TICK, payload, REC_TICK_BYTES, decoded, LEDS));
+}
+
+void test_ring_evicts_oldest_records(void) {
+    uint8_t storage[64];
+    RecordRing ring(storage, sizeof(storage));
+    uint8_t tick[REC_TICK_BYTES];
+    
+    for (uint32_t n = 0; n < 10; n++) {
+        packTick(tick, 1000.0 + n, 0.0, 0.0, 0.0);
+        TEST_ASSERT_TRUE(ring.append(REC_TICK, n, tick, REC_TICK_BYTES));
+    }
+    // 27-byte records: two fit in 64 bytes, the rest were evicted oldest first
+    TEST_ASSERT_EQUAL_UINT32(10, ring.records);
+    TEST_ASSERT_EQUAL_UINT32(8, ring.evicted);
+    TEST_ASSERT_EQUAL_UINT32(2 * (REC_HEADER_BYTES + REC_TICK_BYTES), ring.used);
+    
+    uint8_t bytes[REC_HEADER_BYTES];
+    ring.read(0, bytes, REC_HEADER_BYTES);
+    TEST_ASSERT_EQUAL_UINT32(8, unpackRecordHeader(bytes).timestamp);
+    double price;
+    float changes[3];
+    ring.read(REC_HEADER_BYTES + REC_TICK_BYTES + REC_HEADER_BYTES, tick, REC_TICK_BYTES);
+    unpackTick(tick, price, changes);
+    TEST_ASSERT_EQUAL_DOUBLE(1009.0, price);
+    
+    TEST_ASSERT_FALSE(ring.append(REC_KEYFRAME, 0, payload, 64));  // Could never fit
+}
+
+void test_keyframe_interval_follows_ring_size(void) {
+    // 32x16: 1579-byte worst-case records, ten to a 16 KB ring
+    TEST_ASSERT_EQUAL_UINT32(REC_HEADER_BYTES + REC_INPUT_BYTES + 512 * 3, maxFrameRecordBytes(512));
+    TEST_ASSERT_EQUAL_UINT16(8, keyframeIntervalFor(16384, 512));
+    TEST_ASSERT_EQUAL_UINT16(0, keyframeIntervalFor(16384, 128 * 64));  // Not even one keyframe fits
+}
+
+// Fill the default frame ring many times over; a keyframe must survive every eviction
+// so the tail always decodes, right up to the last frame recorded
+void test_full_frame_ring_tail_decodes(void) {
+    uint16_t interval = keyframeIntervalFor(FRAME_RING_BYTES, LEDS);
+    TEST_ASSERT_GREATER_THAN(0, interval);
+    
+    for (int pattern = 0; pattern < 2; pattern++) {
+        RecordRing ring(ringStorage, sizeof(ringStorage));
+        FrameEncoder encoder(previous, LEDS, interval);
+        memset(frame, 0, sizeof(frame));
+        uint32_t lastRecorded = 0;
+        
+        for (uint32_t n = 1; n <= 2000; n++) {
+            if (pattern == 0) {
+                drawFrame(n);
+            } else {
+                drawNoisyFrame();
+            }
+            if (recordInto(ring, encoder, n)) {
+                lastRecorded = n;
+            }
+            
+            // Check the tail after every append, not just at the end
+            if (n % 97 == 0 || n == 2000) {
+                uint32_t lastDecoded = 0;
+                TEST_ASSERT_GREATER_THAN(0, decodeRing(ring, lastDecoded));
+                TEST_ASSERT_EQUAL_UINT32(lastRecorded, lastDecoded);
+                TEST_ASSERT_EQUAL_MEMORY(frame, decoded, sizeof(frame));
+            }
+        }
+        TEST_ASSERT_GREATER_THAN(0, ring.evicted);
+    }
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_record_header_round_trip);
+    RUN_TEST(test_tick_and_inputs_round_trip);
+    RUN_TEST(test_first_frame_is_keyframe_then_deltas);
+    RUN_TEST(test_round_trip_with_dropped_appends);
+    RUN_TEST(test_keyframe_interval_counts_stored_frames);
+    RUN_TEST(test_large_change_falls_back_to_keyframe);
+    RUN_TEST(test_malformed_records_rejected);
+    RUN_TEST(test_ring_evicts_oldest_records);
+    RUN_TEST(test_keyframe_interval_follows_ring_size);
+    RUN_TEST(test_full_frame_ring_tail_decodes);
+    return UNITY_END();
+}
@@ -0,0 +1,211 @@
+// Hedged price round against fake fetch lanes and a fake clock: a slow primary gets
+// exactly one hedge at its hedge delay, failures fail over, and a round that starts
+// with every lane busy waits for one. Run with: pio test -e native -f test_round
+
+#include <unity.h>
+#include "price_round.h"
+
+const unsigned long TIMEOUT = 10000;   // REQUEST_TIMEOUT
+const int LANES = 2;                   // PRICE_LANES
+
+// Scripted sources: how long each takes to answer and whether the answer is good
+struct FakeSource {
+    unsigned long latency;
+    bool good;
+};
+
+struct FakeLanes {
+    struct Flight {
+        int source;             // -1 for a lane busy with an earlier round
+        unsigned long doneAt;
+        bool busy;
+    };
+    
+    const FakeSource* sources;
+    unsigned long clock;
+    Flight lanes[LANES];
+    int dispatches;
+    int dispatchedSources[8];
+    unsigned long dispatchTimes[8];
+    int hedges;
+    unsigned long hedgeElapsed;
+    
+    FakeLanes(const FakeSource* scripted) : sources(scripted), clock(1000), dispatches(0), hedges(0), hedgeElapsed(0) {
+        for (int i = 0; i < LANES; i++) {
+            lanes[i].busy = false;
+        }
+    }
+    
+    // Occupy a lane with a request from an earlier round, answering after ms
+    void busyFromEarlierRound(int lane, unsigned long ms) {
+        lanes[lane] = {-1, clock + ms, true};
+    }
+    
+    unsigned long now() {
+        return clock;
+    }
+    
+    bool dispatch(int source) {
+        for (int i = 0; i < LANES; i++) {
+            if (!lanes[i].busy) {
+                lanes[i] = {source, clock + sources[source].latency, true};
+                dispatchedSources[dispatches] = source;
+                dispatchTimes[dispatches++] = clock;
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    // The earliest answer within waitMs, moving the clock to it
+    bool await(unsigned long waitMs, int& source, bool& good) {
+        int first = -1;
+        for (int i = 0; i < LANES; i++) {
+            if (lanes[i].busy && lanes[i].doneAt <= clock + waitMs &&
+                (first < 0 || lanes[i].doneAt < lanes[first].doneAt)) {
+                first = i;
+            }
+        }
+        if (first < 0) {
+            clock += waitMs;
+            return false;
+        }
+        clock = lanes[first].doneAt > clock ? lanes[first].doneAt : clock;
+        lanes[first].busy = false;
+        if (lanes[first].source < 0) {
+            return false;  // Answer for an earlier round
+        }
+        source = lanes[first].source;
+        good = sources[source].good;
+        return true;
+    }
+    
+    void hedged(int primary, int hedge, unsigned long elapsed) {
+        hedges++;
+        hedgeElapsed = elapsed;
+    }
+};
+
+const int RANKED[3] = {0, 1, 2};
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+void test_slow_primary_hedged_once_at_delay(void) {
+    const FakeSource sources[3] = {{4000, true}, {300, true}, {200, true}};
+    FakeLanes lanes(sources);
+    RoundOutcome outcome = runHedgedRound(lanes, RANKED, 3, 800, TIMEOUT, true);
+    
+    TEST_ASSERT_TRUE(outcome.hedged);
+    TEST_ASSERT_EQUAL_INT(1, lanes.hedges);
+    TEST_ASSERT_EQUAL_UINT32(800, lanes.hedgeElapsed);
+    TEST_ASSERT_EQUAL_INT(2, lanes.dispatches);
+    TEST_ASSERT_EQUAL_INT(1, lanes.dispatchedSources[1]);
+    TEST_ASSERT_EQUAL_UINT32(1800, lanes.dispatchTimes[1]);
+    TEST_ASSERT_EQUAL_INT(1, outcome.winner);
+    TEST_ASSERT_EQUAL_UINT32(2100, lanes.clock);  // Hedge answered 300 ms after firing
+}
+
+// Both slow: still only one hedge, and the third source isn't fired alongside
+void test_one_hedge_per_round(void) {
+    const FakeSource sources[3] = {{5000, true}, {4000, true}, {100, true}};
+    FakeLanes lanes(sources);
+    RoundOutcome outcome = runHedgedRound(lanes, RANKED, 3, 500, TIMEOUT, true);
+    
+    TEST_ASSERT_EQUAL_INT(1, lanes.hedges);
+    TEST_ASSERT_EQUAL_INT(2, outcome.dispatched);
+    TEST_ASSERT_EQUAL_INT(1, outcome.winner);
+}
+
+void test_fast_primary_not_hedged(void) {
+    const FakeSource sources[3] = {{200, true}, {300, true}, {300, true}};
+    FakeLanes lanes(sources);
+    RoundOutcome outcome = runHedgedRound(lanes, RANKED, 3, 800, TIMEOUT, true);
+    
+    TEST_ASSERT_FALSE(outcome.hedged);
+    TEST_ASSERT_EQUAL_INT(1, lanes.dispatches);
+    TEST_ASSERT_EQUAL_INT(0, outcome.winner);
+}
+
+void test_hedging_off_waits_for_primary(void) {
+    const FakeSource sources[3] = {{4000, true}, {300, true}, {300, true}};
+    FakeLanes lanes(sources);
+    RoundOutcome outcome = runHedgedRound(lanes, RANKED, 3, 800, TIMEOUT, false);
+    
+    TEST_ASSERT_EQUAL_INT(0, lanes.hedges);
+    TEST_ASSERT_EQUAL_INT(0, outcome.winner);
+    TEST_ASSERT_EQUAL_UINT32(5000, lanes.clock);
+}
+
+// A failed primary fails over straight away; that isn't a hedge
+void test_failure_fails_over(void) {
+    const FakeSource sources[3] = {{100, false}, {150, false}, {200, true}};
+    FakeLanes lanes(sources);
+    RoundOutcome outcome = runHedgedRound(lanes, RANKED, 3, 800, TIMEOUT, true);
+    
+    TEST_ASSERT_FALSE(outcome.hedged);
+    TEST_ASSERT_EQUAL_INT(3, outcome.dispatched);
+    TEST_ASSERT_EQUAL_INT(2, outcome.winner);
+    TEST_ASSERT_EQUAL_UINT32(1450, lanes.clock);
+}
+
+void test_all_failed_ends_early(void) {
+    const FakeSource sources[3] = {{100, false}, {100, false}, {100, false}};
+    FakeLanes lanes(sources);
+    RoundOutcome outcome = runHedgedRound(lanes, RANKED, 3, 800, TIMEOUT, true);
+    
+    TEST_ASSERT_EQUAL_INT(-1, outcome.winner);
+    TEST_ASSERT_EQUAL_UINT32(1300, lanes.clock);
+}
+
+// Both lanes still on the previous round's stragglers: wait for one, don't give up
+void test_busy_lanes_waited_for(void) {
+    const FakeSource sources[3] = {{200, true}, {300, true}, {300, true}};
+    FakeLanes lanes(sources);
+    lanes.busyFromEarlierRound(0, 700);
+    lanes.busyFromEarlierRound(1, 900);
+    RoundOutcome outcome = runHedgedRound(lanes, RANKED, 3, 800, TIMEOUT, true);
+    
+    TEST_ASSERT_EQUAL_INT(0, outcome.winner);
+    TEST_ASSERT_EQUAL_UINT32(1700, lanes.dispatchTimes[0]);
+    TEST_ASSERT_EQUAL_UINT32(1900, lanes.clock);
+}
+
+// Hedge point reached while the other lane is busy: the hedge goes out when it frees
+void test_hedge_waits_for_a_lane(void) {
+    const FakeSource sources[3] = {{4000, true}, {300, true}, {300, true}};
+    FakeLanes lanes(sources);
+    lanes.busyFromEarlierRound(1, 1200);
+    RoundOutcome outcome = runHedgedRound(lanes, RANKED, 3, 800, TIMEOUT, true);
+    
+    TEST_ASSERT_EQUAL_INT(1, lanes.hedges);
+    TEST_ASSERT_EQUAL_UINT32(2200, lanes.dispatchTimes[1]);
+    TEST_ASSERT_EQUAL_INT(1, outcome.winner);
+}
+
+void test_no_candidates(void) {
+    const FakeSource sources[1] = {{100, true}};
+    FakeLanes lanes(sources);
+    RoundOutcome outcome = runHedgedRound(lanes, RANKED, 0, 0, TIMEOUT, true);
+    
+    TEST_ASSERT_EQUAL_INT(-1, outcome.winner);
+    TEST_ASSERT_EQUAL_INT(0, lanes.dispatches);
+    TEST_ASSERT_EQUAL_UINT32(1000, lanes.clock);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_slow_primary_hedged_once_at_delay);
+    RUN_TEST(test_one_hedge_per_round);
+    RUN_TEST(test_fast_primary_not_hedged);
+    RUN_TEST(test_hedging_off_waits_for_primary);
+    RUN_TEST(test_failure_fails_over);
+    RUN_TEST(test_all_failed_ends_early);
+    RUN_TEST(test_busy_lanes_waited_for);
+    RUN_TEST(test_hedge_waits_for_a_lane);
+    RUN_TEST(test_no_candidates);
+    return UNITY_END();
+}
@@ -0,0 +1,148 @@
+// ScrollState and FramePacer against a fake clock: frame jitter, stall recovery and
+// scroll position error. Run with: pio test -e native -f test_scroll
+
+#include <unity.h>
+#include <stdlib.h>
+#include "frame_timing.h"
+
+// Simulated time. Every micros() read costs a microsecond so spin waits terminate;
+// waitForNotify() sleeps until the timeout or a pending notification.
+struct FakeClock {
+    static unsigned long now;
+    static unsigned long notifyAt;  // Time a notification arrives, 0 = none
+    
+    static unsigned long micros() {
+        return now++;
+    }
+    
+    static bool waitForNotify(unsigned long ms) {
+        unsigned long until = now + ms * 1000;
+        if (notifyAt != 0 && (long)(notifyAt - until) <= 0) {
+            if ((long)(notifyAt - now) > 0) {
+                now = notifyAt;
+            }
+            notifyAt = 0;
+            return true;
+        }
+        now = until;
+        return false;
+    }
+};
+
+unsigned long FakeClock::now = 0;
+unsigned long FakeClock::notifyAt = 0;
+
+const unsigned long FRAME_WORK_US = 2000;  // Simulated render + show() per frame
+
+void setUp(void) {
+    FakeClock::now = 1000000;
+    FakeClock::notifyAt = 0;
+}
+
+void tearDown(void) {
+}
+
+void test_frames_are_evenly_spaced(void) {
+    FramePacer<FakeClock> pacer(60);
+    pacer.wait();
+    unsigned long previous = FakeClock::now;
+    long worstJitter = 0;
+    
+    for (int frame = 0; frame < 600; frame++) {
+        FakeClock::now += FRAME_WORK_US;
+        pacer.wait();
+        long jitter = labs((long)(FakeClock::now - previous) - (long)pacer.frameMicros);
+        worstJitter = jitter > worstJitter ? jitter : worstJitter;
+        previous = FakeClock::now;
+    }
+    
+    TEST_ASSERT_EQUAL_UINT32(0, pacer.missedFrames);
+    TEST_ASSERT_LESS_OR_EQUAL(5, worstJitter);
+}
+
+void test_stall_resyncs_without_burst(void) {
+    FramePacer<FakeClock> pacer(60);
+    pacer.wait();
+    unsigned long previous = FakeClock::now;
+    
+    for (int frame = 0; frame < 120; frame++) {
+        bool stalled = frame == 50;
+        FakeClock::now += stalled ? 100000 : FRAME_WORK_US;  // One 100 ms stall (e.g. a web request)
+        pacer.wait();
+        unsigned long interval = FakeClock::now - previous;
+        previous = FakeClock::now;
+        
+        if (stalled) {
+            TEST_ASSERT_EQUAL_UINT32(1, pacer.missedFrames);
+        } else {
+            // No catch-up burst: every other frame keeps the full period
+            TEST_ASSERT_GREATER_OR_EQUAL(pacer.frameMicros - 5, interval);
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT32(1, pacer.missedFrames);
+}
+
+void test_scroll_position_tracks_elapsed_time_through_stalls(void) {
+    FramePacer<FakeClock> pacer(60);
+    ScrollState scroll(400, 100);  // 10 px/s, far enough right not to wrap
+    unsigned long startMs = FakeClock::now / 1000;
+    float worstError = 0;
+    srand(1);
+    
+    for (int frame = 0; frame < 1200; frame++) {
+        unsigned long nowMs = FakeClock::now / 1000;
+        scroll.advance(nowMs);
+        float expected = 400 - (nowMs - startMs) * 10 / 1000.0f;
+        worstError = fmaxf(worstError, fabsf(scroll.position - expected));
+        
+        // Every few dozen frames a stall of 20-250 ms
+        FakeClock::now += frame % 37 == 36 ? 20000 + rand() % 230000 : FRAME_WORK_US;
+        pacer.wait();
+    }
+    
+    TEST_ASSERT_GREATER_THAN(0, pacer.missedFrames);
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 0.0f, worstError);
+}
+
+void test_wrap_carries_overshoot(void) {
+    ScrollState scroll(32, 100);
+    scroll.position = -40.5f;
+    scroll.wrap(32, 40);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 31.5f, scroll.position);
+    
+    // Stalled for more than a whole cycle: restart at the reset offset
+    scroll.position = -200.0f;
+    scroll.wrap(32, 40);
+    TEST_ASSERT_FLOAT_WITHIN(0.001f, 32.0f, scroll.position);
+}
+
+void test_notification_wakes_renderer_early(void) {
+    FramePacer<FakeClock> pacer(60);
+    pacer.wait();
+    unsigned long scheduled = pacer.nextFrame;
+    
+    FakeClock::notifyAt = FakeClock::now + 4000;
+    pacer.wait();
+    TEST_ASSERT_TRUE(pacer.updateSignalled);
+    TEST_ASSERT_LESS_OR_EQUAL(4001, FakeClock::now - (scheduled - pacer.frameMicros));
+    TEST_ASSERT_EQUAL_UINT32(scheduled, pacer.nextFrame);  // Frame schedule kept
+}
+
+void test_idle_wait_sleeps_until_timeout(void) {
+    FramePacer<FakeClock> pacer(60);
+    unsigned long start = FakeClock::now;
+    pacer.wait(false);
+    TEST_ASSERT_FALSE(pacer.updateSignalled);
+    TEST_ASSERT_GREATER_OR_EQUAL(IDLE_FRAME_MS * 1000UL, FakeClock::now - start);
+}
+
+int main(int argc, char** argv) {
+    UNITY_BEGIN();
+    RUN_TEST(test_frames_are_evenly_spaced);
+    RUN_TEST(test_stall_resyncs_without_burst);
+    RUN_TEST(test_scroll_position_tracks_elapsed_time_through_stalls);
+    RUN_TEST(test_wrap_carries_overshoot);
+    RUN_TEST(test_notification_wakes_renderer_early);
+    RUN_TEST(test_idle_wait_sleeps_until_timeout);
+    return UNITY_END();
+}